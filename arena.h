@@ -0,0 +1,50 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+#include <stddef.h>
+
+// 작업 버퍼용 bump 아레나: 한 번에 할당하고 한 번에 해제
+// (할당은 작업을 만드는 스레드 하나에서만 호출)
+
+#define ARENA_ALIGN 64  // 캐시 라인 정렬로 작업 간 false sharing 방지
+
+// 파일 크기 1 단위당 작업 버퍼 바이트 수 (대규모 작업 목록에서는 --workload ...,unit=N 으로 축소)
+#define BYTES_PER_UNIT 1024
+static size_t bytes_per_unit = BYTES_PER_UNIT;
+#define TASK_BUF_BYTES(size) ((size_t)(size) * bytes_per_unit)
+
+typedef struct {
+    char* base;
+    size_t used;
+    size_t cap;
+} Arena;
+
+static inline int arena_init(Arena* a, size_t cap) {
+    a->base = aligned_alloc(ARENA_ALIGN, (cap + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1));
+    a->used = 0;
+    a->cap = cap;
+    return a->base ? 0 : -1;
+}
+
+// 64바이트 단위로 올림해서 잘라줌, 공간이 없으면 NULL
+static inline void* arena_alloc(Arena* a, size_t size) {
+    size_t need = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (a->used + need > a->cap) return NULL;
+    void* p = a->base + a->used;
+    a->used += need;
+    return p;
+}
+
+// n 바이트 요청이 아레나에서 실제로 차지하는 크기
+static inline size_t arena_size(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static inline void arena_destroy(Arena* a) {
+    free(a->base);
+    a->base = NULL;
+    a->used = a->cap = 0;
+}
+
+#endif
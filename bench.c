@@ -0,0 +1,553 @@
+// bench.c — 반복 측정 성능 회귀 검사: 구성별 중앙값과 신뢰구간, 기준선(JSON) 비교
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "codec.h"
+#include "crc32c.h"
+#include "hash.h"
+
+#define DEFAULT_RUNS 10
+#define DEFAULT_WARMUP 1
+#define DEFAULT_THRESHOLD 5.0  // 중앙값이 이 % 이상 느려지고
+#define SIGNIFICANCE_Z 2.326   // 단측 Mann-Whitney U 검정에서 p < 0.01 이어야 회귀로 판정
+#define MIN_COMPARE_RUNS 5     // 양쪽 표본이 이보다 적으면 z 가 SIGNIFICANCE_Z 에 닿을 수 없음 (n=4 에서 최대 2.31)
+#define CI_Z 1.96              // 중앙값의 95% 신뢰구간 (순서 통계량)
+#define MAX_RUNS 1000
+#define MAX_EXTRA_ARGS 32
+#define KERNEL_BYTES (1 << 20)  // 커널 벤치마크 입력 기본값 (BWT 블록 하나 크기)
+#define KERNEL_MAX_MB 64
+#define EXIT_REGRESSION 2
+
+// 프로세스/스레드 구성 (run.c 의 C0~C14 구분을 따름)
+//   C0 순차, C1~C5 process-only, C6~C9 thread-only, C10~C14 hybrid
+typedef struct {
+    const char* name;
+    int P, T;
+} Config;
+
+static const Config configs[] = {
+    { "C0", 0, 0 },
+    { "C1", 1, 0 }, { "C2", 2, 0 }, { "C3", 4, 0 }, { "C4", 8, 0 }, { "C5", 16, 0 },
+    { "C6", 0, 2 }, { "C7", 0, 4 }, { "C8", 0, 8 }, { "C9", 0, 16 },
+    { "C10", 2, 2 }, { "C11", 2, 4 }, { "C12", 4, 2 }, { "C13", 4, 4 }, { "C14", 8, 2 },
+};
+#define CONFIG_COUNT (int)(sizeof(configs) / sizeof(configs[0]))
+
+// 커널 마이크로벤치마크: 같은 입력으로 한 번 실행하는 함수
+typedef struct {
+    uint8_t* text;  // 원본 (단어를 이어 붙인 텍스트)
+    uint8_t* bwt;   // BWT 결과 (MTF 입력)
+    uint8_t* mtf;   // MTF 결과 (RLE 입력)
+    uint8_t* rle;   // RLE 결과 (Huffman 입력)
+    uint8_t* out;
+    uint8_t* work;
+    int len, rle_len, primary;
+    int streams;  // 역변환 줄기 수와 앵커 (bwt_stream_count 기준, 압축과 같게)
+    int anchors[BWT_MAX_STREAMS - 1];
+    uint64_t sink;  // 최적화로 사라지지 않게 결과를 모음
+} KernelInput;
+
+typedef struct {
+    const char* name;
+    void (*run)(KernelInput* k);
+} Kernel;
+
+typedef struct {
+    char name[32];
+    double samples[MAX_RUNS];
+    int n;
+    double median, ci_lo, ci_hi;
+    double base_median;  // 기준선이 없으면 -1
+    int verdict;         // -1 빨라짐, 0 차이 없음, 1 회귀
+} Result;
+
+static int runs = DEFAULT_RUNS, warmup = DEFAULT_WARMUP;
+static double threshold = DEFAULT_THRESHOLD;
+static const char* program = "./run";
+static char* extra_args[MAX_EXTRA_ARGS];
+static int extra_count = 0;
+static cpu_set_t cpus;
+static int pinned_cpu = -1;  // 커널 벤치마크를 고정할 CPU (cpus 의 첫 번째)
+static int kernel_bytes = KERNEL_BYTES;
+static volatile uint64_t kernel_sink;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void serial_for(par_fn fn, void* ctx, int items) {
+    for (int i = 0; i < items; i++) fn(ctx, i);
+}
+
+static void kernel_bwt(KernelInput* k) {
+    int primary, anchors[BWT_MAX_STREAMS - 1];
+    bwt_encode_ws(k->text, k->out, k->len, &primary, anchors, k->streams, k->work);
+    k->sink += primary;
+}
+
+// 역변환 세 가지: 행 번호와 심볼을 따로 읽는 한 줄기 (이전 방식),
+// 32비트로 묶은 한 줄기, 묶은 표 + 앵커로 여러 줄기
+static void kernel_bwt_decode_lf(KernelInput* k) {
+    bwt_decode_lf(k->bwt, k->out, k->len, k->primary);
+    k->sink += k->out[k->len / 2];
+}
+
+static void kernel_bwt_decode(KernelInput* k) {
+    bwt_decode(k->bwt, k->out, k->len, k->primary);
+    k->sink += k->out[k->len / 2];
+}
+
+static void kernel_bwt_decode_ms(KernelInput* k) {
+    bwt_decode_streams(k->bwt, k->out, k->len, k->primary, k->anchors, k->streams);
+    k->sink += k->out[k->len / 2];
+}
+
+// MTF 는 제자리 변환이라 복사본에서 (복사 비용 포함)
+static void kernel_mtf(KernelInput* k) {
+    memcpy(k->out, k->bwt, k->len);
+    mtf_encode(k->out, k->len);
+    k->sink += k->out[k->len / 2];
+}
+
+static void kernel_rle(KernelInput* k) {
+    k->sink += rle_encode(k->mtf, k->len, k->out);
+}
+
+static void kernel_huf(KernelInput* k) {
+    HufJob huf;
+    size_t size = huf_plan(&huf, k->rle, k->rle_len, serial_for);
+    if (size != (size_t)-1) {
+        huf_encode(&huf, k->out, serial_for);
+        huf_free(&huf);
+    }
+    k->sink += size;
+}
+
+static void kernel_lz(KernelInput* k) {
+    k->sink += lz_encode(k->text, k->len, k->out, k->len);
+}
+
+static void kernel_probe(KernelInput* k) {
+    Probe p = probe_block(k->text, k->len);
+    k->sink += (uint64_t)(p.bits * 1000);
+}
+
+static void kernel_crc32c(KernelInput* k) {
+    k->sink += crc32c(0, k->text, k->len);
+}
+
+static void kernel_xxh64(KernelInput* k) {
+    k->sink += xxh64(k->text, k->len, 0);
+}
+
+static const Kernel kernels[] = {
+    { "bwt", kernel_bwt },
+    { "bwt_decode_lf", kernel_bwt_decode_lf },
+    { "bwt_decode", kernel_bwt_decode },
+    { "bwt_decode_ms", kernel_bwt_decode_ms },
+    { "mtf", kernel_mtf },
+    { "rle", kernel_rle },
+    { "huffman", kernel_huf },
+    { "lz", kernel_lz },
+    { "probe", kernel_probe },
+    { "crc32c", kernel_crc32c },
+    { "xxh64", kernel_xxh64 },
+};
+#define KERNEL_COUNT (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+// 압축이 적당히 되는 입력: 작은 어휘에서 고른 단어를 이어 붙임 (시드 고정)
+static int kernel_input_init(KernelInput* k, int len) {
+    static const char* words[] = {
+        "the", "block", "thread", "process", "queue", "worker", "mutex", "compress",
+        "stage", "buffer", "sort", "rank", "symbol", "run", "length", "table",
+    };
+    memset(k, 0, sizeof(*k));
+    k->len = len;
+    k->text = malloc(len);
+    k->bwt = malloc(len);
+    k->mtf = malloc(len);
+    k->rle = malloc(RLE_BOUND((size_t)len));
+    k->out = malloc(RLE_BOUND((size_t)len) + HUF_HEADER);
+    k->work = malloc(BWT_WORK_BYTES(len));
+    if (!k->text || !k->bwt || !k->mtf || !k->rle || !k->out || !k->work) return -1;
+    uint64_t s = 1;
+    for (int i = 0; i < len; ) {
+        s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+        const char* w = words[(s >> 33) % 16];
+        while (*w && i < len) k->text[i++] = *w++;
+        if (i < len) k->text[i++] = (s >> 40) % 7 == 0 ? '\n' : ' ';
+    }
+    k->streams = bwt_stream_count(len);
+    if (bwt_encode_ws(k->text, k->bwt, len, &k->primary, k->anchors, k->streams, k->work) < 0) return -1;
+    memcpy(k->mtf, k->bwt, len);
+    mtf_encode(k->mtf, len);
+    k->rle_len = rle_encode(k->mtf, len, k->rle);
+    return 0;
+}
+
+static void kernel_input_free(KernelInput* k) {
+    free(k->text); free(k->bwt); free(k->mtf); free(k->rle); free(k->out); free(k->work);
+}
+
+// 구성 하나를 자식 프로세스로 실행하고 "Total compression time" 을 읽음 (실패하면 -1)
+static double run_config(const Config* c) {
+    char p[16], t[16];
+    snprintf(p, sizeof(p), "%d", c->P);
+    snprintf(t, sizeof(t), "%d", c->T);
+    char* argv[MAX_EXTRA_ARGS + 4];
+    int argc = 0;
+    argv[argc++] = (char*)program;
+    for (int i = 0; i < extra_count; i++) argv[argc++] = extra_args[i];
+    argv[argc++] = p;
+    argv[argc++] = t;
+    argv[argc] = NULL;
+
+    int fds[2];
+    if (pipe(fds) < 0) {
+        perror("pipe failed");
+        return -1.0;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        close(fds[0]);
+        close(fds[1]);
+        return -1.0;
+    }
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) dup2(devnull, STDERR_FILENO);
+        execv(program, argv);
+        _exit(127);
+    }
+    close(fds[1]);
+    FILE* in = fdopen(fds[0], "r");
+    double ms = -1.0;
+    char line[512];
+    while (in && fgets(line, sizeof(line), in)) {
+        double v;
+        if (sscanf(line, "Total compression time: %lf ms", &v) == 1) ms = v;
+    }
+    if (in) fclose(in);
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1.0;
+    return ms;
+}
+
+// 커널 하나를 한 번 실행한 시간 (ms)
+static double run_kernel(const Kernel* k, KernelInput* in) {
+    double t0 = now_ms();
+    k->run(in);
+    return now_ms() - t0;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// 중앙값과 순서 통계량 기반 95% 신뢰구간 (분포 가정 없음)
+static void summarize(Result* r) {
+    double s[MAX_RUNS];
+    int n = r->n;
+    memcpy(s, r->samples, sizeof(double) * n);
+    qsort(s, n, sizeof(double), cmp_double);
+    r->median = n % 2 ? s[n / 2] : (s[n / 2 - 1] + s[n / 2]) / 2;
+    int lo = (int)floor((n - CI_Z * sqrt(n)) / 2);
+    int hi = (int)ceil((n + CI_Z * sqrt(n)) / 2) - 1;
+    r->ci_lo = s[lo < 0 ? 0 : lo];
+    r->ci_hi = s[hi >= n ? n - 1 : hi];
+}
+
+// 단측 Mann-Whitney U: 현재 표본이 기준선보다 클수록 양수인 z
+static double mann_whitney_z(const double* a, int na, const double* b, int nb) {
+    double u = 0;
+    for (int i = 0; i < na; i++)
+        for (int j = 0; j < nb; j++)
+            u += a[i] > b[j] ? 1.0 : a[i] == b[j] ? 0.5 : 0.0;
+    double mean = na * (double)nb / 2;
+    double sd = sqrt(na * (double)nb * (na + nb + 1) / 12.0);
+    return sd > 0 ? (u - mean) / sd : 0.0;
+}
+
+// 기준선 JSON 에서 name 의 표본을 읽음 (이 프로그램이 쓴 형식만 지원), 없으면 0
+static int baseline_samples(const char* json, const char* name, double* out) {
+    char key[64];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    const char* p = strstr(json, key);
+    if (!p) return 0;
+    const char* end = strchr(p, '}');
+    p = strstr(p, "\"samples\": [");
+    if (!p || (end && p > end)) return 0;
+    p += strlen("\"samples\": [");
+    int n = 0;
+    while (n < MAX_RUNS) {
+        char* next;
+        double v = strtod(p, &next);
+        if (next == p) break;
+        out[n++] = v;
+        p = next;
+        while (*p == ',' || *p == ' ' || *p == '\n') p++;
+    }
+    return n;
+}
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* buf = malloc(len + 1);
+    if (buf && fread(buf, 1, len, f) != (size_t)len) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) buf[len] = '\0';
+    fclose(f);
+    return buf;
+}
+
+static int save_results(const char* path, const Result* res, int count) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    fprintf(f, "{\n  \"host\": \"%s\",\n  \"cpus\": %d,\n  \"runs\": %d,\n  \"warmup\": %d,\n  \"results\": [\n",
+        host, CPU_COUNT(&cpus), runs, warmup);
+    for (int i = 0; i < count; i++) {
+        const Result* r = &res[i];
+        fprintf(f, "    {\"name\": \"%s\", \"unit\": \"ms\", \"median\": %.6f, \"ci_low\": %.6f, \"ci_high\": %.6f, \"samples\": [",
+            r->name, r->median, r->ci_lo, r->ci_hi);
+        for (int j = 0; j < r->n; j++)
+            fprintf(f, "%s%.6f", j ? ", " : "", r->samples[j]);
+        fprintf(f, "]}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f);
+}
+
+// "0-3,6" 형식의 CPU 목록
+static int parse_cpus(const char* s, cpu_set_t* set) {
+    CPU_ZERO(set);
+    while (*s) {
+        char* end;
+        long a = strtol(s, &end, 10), b = a;
+        if (end == s || a < 0) return -1;
+        if (*end == '-') {
+            s = end + 1;
+            b = strtol(s, &end, 10);
+            if (end == s || b < a) return -1;
+        }
+        for (long c = a; c <= b && c < CPU_SETSIZE; c++) CPU_SET(c, set);
+        if (*end == ',') end++;
+        else if (*end) return -1;
+        s = end;
+    }
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+// 이름 목록이 비었거나 name 이 들어 있으면 선택 ("configs", "kernels" 는 묶음)
+static int selected(char** names, int n, const char* name, int is_kernel) {
+    if (n == 0) return 1;
+    for (int i = 0; i < n; i++) {
+        if (strcmp(names[i], name) == 0) return 1;
+        if (strcmp(names[i], is_kernel ? "kernels" : "configs") == 0) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* baseline_path = NULL, * save_path = NULL, * cpu_list = NULL;
+    char* arg_string = NULL;
+    int opt, kernel_mb = 0;
+    while ((opt = getopt(argc, argv, "n:w:c:b:s:t:x:a:k:")) != -1) {
+        switch (opt) {
+        case 'n': runs = atoi(optarg); break;
+        case 'w': warmup = atoi(optarg); break;
+        case 'c': cpu_list = optarg; break;
+        case 'b': baseline_path = optarg; break;
+        case 's': save_path = optarg; break;
+        case 't': threshold = atof(optarg); break;
+        case 'x': program = optarg; break;
+        case 'a': arg_string = optarg; break;  // 구성 실행 시 P T 앞에 붙일 인자 (공백 구분)
+        case 'k': kernel_mb = atoi(optarg); break;  // 커널 입력 크기 (MB)
+        default:
+            fprintf(stderr, "Usage: %s [-n runs] [-w warmup] [-c cpu_list] [-b baseline.json] [-s save.json]\n"
+                "       [-t threshold_pct] [-x program] [-a \"program args\"] [-k kernel_mb]\n"
+                "       [configs|kernels|C0..C14|kernel_name ...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (runs < 3 || runs > MAX_RUNS || warmup < 0) {
+        fprintf(stderr, "Invalid run count (3 ~ %d) or warmup.\n", MAX_RUNS);
+        return 1;
+    }
+    if (baseline_path && runs < MIN_COMPARE_RUNS) {
+        fprintf(stderr, "Baseline comparison needs at least %d runs (-n), or no slowdown can ever be significant.\n",
+            MIN_COMPARE_RUNS);
+        return 1;
+    }
+    if (kernel_mb) {
+        if (kernel_mb < 1 || kernel_mb > KERNEL_MAX_MB) {
+            fprintf(stderr, "Invalid kernel input size (1 ~ %d MB).\n", KERNEL_MAX_MB);
+            return 1;
+        }
+        kernel_bytes = kernel_mb << 20;
+    }
+    if (arg_string) {
+        for (char* tok = strtok(arg_string, " "); tok; tok = strtok(NULL, " ")) {
+            if (extra_count == MAX_EXTRA_ARGS) {
+                fprintf(stderr, "Too many program arguments.\n");
+                return 1;
+            }
+            extra_args[extra_count++] = tok;
+        }
+    }
+
+    // CPU 고정: 벤치마크와 자식이 모두 같은 CPU 집합에서만 돌게 (마이그레이션으로 인한 잡음 제거)
+    if (cpu_list ? parse_cpus(cpu_list, &cpus) < 0 : sched_getaffinity(0, sizeof(cpus), &cpus) < 0) {
+        fprintf(stderr, "Invalid CPU list '%s'.\n", cpu_list ? cpu_list : "");
+        return 1;
+    }
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+        perror("sched_setaffinity failed");
+        return 1;
+    }
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &cpus)) {
+            pinned_cpu = c;
+            break;
+        }
+    }
+
+    char* baseline = NULL;
+    if (baseline_path && (baseline = read_file(baseline_path)) == NULL) {
+        perror(baseline_path);
+        return 1;
+    }
+
+    char** names = argv + optind;
+    int nnames = argc - optind;
+    Result* res = calloc(CONFIG_COUNT + KERNEL_COUNT, sizeof(Result));
+    int count = 0, failed = 0;
+
+    printf("[bench] %d runs (+%d warmup) per benchmark on %d CPUs, threshold %.1f %%\n",
+        runs, warmup, CPU_COUNT(&cpus), threshold);
+    fflush(stdout);
+
+    // 1) 프로세스/스레드 구성
+    for (int i = 0; i < CONFIG_COUNT; i++) {
+        if (!selected(names, nnames, configs[i].name, 0)) continue;
+        Result* r = &res[count];
+        snprintf(r->name, sizeof(r->name), "%s", configs[i].name);
+        for (int j = 0; j < warmup + runs; j++) {
+            double ms = run_config(&configs[i]);
+            if (ms < 0) {
+                fprintf(stderr, "%s: %s %d %d failed.\n", r->name, program, configs[i].P, configs[i].T);
+                failed = 1;
+                break;
+            }
+            if (j >= warmup) r->samples[r->n++] = ms;
+        }
+        if (r->n == runs) count++;
+        else memset(r, 0, sizeof(*r));
+    }
+
+    // 2) 커널 마이크로벤치마크 (한 CPU 에 고정)
+    KernelInput in;
+    int want_kernels = 0;
+    for (int i = 0; i < KERNEL_COUNT; i++) want_kernels |= selected(names, nnames, kernels[i].name, 1);
+    if (want_kernels) {
+        if (kernel_input_init(&in, kernel_bytes) < 0) {
+            fprintf(stderr, "Out of memory for kernel input.\n");
+            return 1;
+        }
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(pinned_cpu, &one);
+        sched_setaffinity(0, sizeof(one), &one);
+        for (int i = 0; i < KERNEL_COUNT; i++) {
+            if (!selected(names, nnames, kernels[i].name, 1)) continue;
+            Result* r = &res[count++];
+            // 기본 크기가 아니면 이름에 크기를 붙여서 기준선이 섞이지 않게
+            if (kernel_bytes == KERNEL_BYTES) snprintf(r->name, sizeof(r->name), "%s", kernels[i].name);
+            else snprintf(r->name, sizeof(r->name), "%s@%dM", kernels[i].name, kernel_bytes >> 20);
+            for (int j = 0; j < warmup + runs; j++) {
+                double ms = run_kernel(&kernels[i], &in);
+                if (j >= warmup) r->samples[r->n++] = ms;
+            }
+        }
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+        kernel_sink = in.sink;
+        kernel_input_free(&in);
+    }
+    if (count == 0) {
+        fprintf(stderr, "No benchmarks selected.\n");
+        return 1;
+    }
+
+    // 3) 요약과 기준선 비교: 중앙값 차이가 threshold 이상이고 U 검정이 유의할 때만 판정
+    int regressions = 0, too_few = 0;
+    printf("\n%-18s %12s   %-25s %12s %9s  %s\n", "benchmark", "median", "95% CI", "baseline", "change", "verdict");
+    for (int i = 0; i < count; i++) {
+        Result* r = &res[i];
+        summarize(r);
+        r->base_median = -1.0;
+        char ci[64], base[32] = "-", change[32] = "-";
+        const char* verdict = baseline ? "new" : "";
+        snprintf(ci, sizeof(ci), "[%.3f, %.3f]", r->ci_lo, r->ci_hi);
+        double b[MAX_RUNS];
+        int nb = baseline ? baseline_samples(baseline, r->name, b) : 0;
+        if (nb > 0 && nb < MIN_COMPARE_RUNS) {
+            verdict = "too few";  // 기준선 표본이 적어서 판정할 수 없음 (실패로 처리)
+            too_few++;
+        } else if (nb > 0) {
+            Result br = { .n = nb };
+            memcpy(br.samples, b, sizeof(double) * nb);
+            summarize(&br);
+            r->base_median = br.median;
+            double pct = (r->median / br.median - 1.0) * 100.0;
+            double z = mann_whitney_z(r->samples, r->n, b, nb);
+            if (pct >= threshold && z >= SIGNIFICANCE_Z) r->verdict = 1;
+            else if (pct <= -threshold && z <= -SIGNIFICANCE_Z) r->verdict = -1;
+            snprintf(base, sizeof(base), "%.3f", br.median);
+            snprintf(change, sizeof(change), "%+.1f%%", pct);
+            verdict = r->verdict > 0 ? "SLOWER" : r->verdict < 0 ? "faster" : "ok";
+            regressions += r->verdict > 0;
+        }
+        printf("%-18s %9.3f ms   %-25s %12s %9s  %s\n", r->name, r->median, ci, base, change, verdict);
+    }
+    if (baseline)
+        printf("\n%d significant slowdown%s (threshold %.1f %%, one-sided Mann-Whitney p < 0.01)\n",
+            regressions, regressions == 1 ? "" : "s", threshold);
+    if (too_few > 0) {
+        fprintf(stderr, "%d benchmark%s not compared: baseline has fewer than %d samples (re-save it with -n %d or more).\n",
+            too_few, too_few == 1 ? "" : "s", MIN_COMPARE_RUNS, MIN_COMPARE_RUNS);
+        failed = 1;
+    }
+
+    if (save_path && save_results(save_path, res, count) < 0) failed = 1;
+    free(baseline);
+    free(res);
+    if (regressions > 0) return EXIT_REGRESSION;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,932 @@
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// 실제 데이터용 BWT / MTF / RLE / Huffman / LZ 커널 (compress.c 에서 사용)
+
+// RLE 출력 최대 크기: 4바이트 런마다 카운트 1바이트가 붙는 최악의 경우
+#define RLE_BOUND(n) ((n) + (n) / 4 + 16)
+
+static inline int bwt_cmp_int(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return x < y ? -1 : x > y;
+}
+
+// 호출 측이 준 작업 메모리에서 64바이트 단위로 잘라 씀
+static inline void* codec_carve(uint8_t** cur, size_t bytes) {
+    void* p = *cur;
+    *cur += (bytes + 63) & ~(size_t)63;
+    return p;
+}
+
+// bwt_encode_ws 에 필요한 작업 메모리 (int 배열 4개)
+#define BWT_WORK_BYTES(n) (4 * (sizeof(int) * ((size_t)(n) > 256 ? (size_t)(n) : 256) + 64))
+
+// 역변환 줄기: 블록을 streams 개 구간으로 나누고 구간마다 따로 LF-mapping 을 따라가서
+// 서로 의존하지 않는 메모리 접근을 겹침. 구간 k 의 끝 위치에서 시작하는 회전의 행 번호가
+// 앵커 k (마지막 구간은 primary). 앵커는 정방향 변환이 정렬 결과에서 뽑아 블록에 같이 저장
+#define BWT_STREAMS 8                // 압축 시 쓰는 줄기 수
+#define BWT_MAX_STREAMS 16           // 해제가 받아들이는 상한
+#define BWT_STREAM_MIN (256 * 1024)  // 이보다 작은 블록은 캐시에 들어가므로 한 줄기
+#define BWT_PACKED_MAX (1 << 24)     // 행 번호 24비트 + 심볼 8비트를 32비트 하나로 묶을 수 있는 크기
+
+// 길이 n 블록에 쓸 줄기 수 (앵커는 이보다 하나 적음)
+static inline int bwt_stream_count(int n) {
+    return n >= BWT_STREAM_MIN && n <= BWT_PACKED_MAX ? BWT_STREAMS : 1;
+}
+
+// 줄기 하나가 맡는 길이 (마지막 줄기는 나머지)
+static inline int bwt_segment(int n, int streams) {
+    return (n + streams - 1) / streams;
+}
+
+// 정렬된 회전 sa 에서 BWT 출력, primary, 앵커 (streams > 1 이면 streams - 1 개) 를 뽑음
+static inline void bwt_emit(const uint8_t* in, const int* sa, uint8_t* out, int n, int* primary,
+    int* anchors, int streams) {
+    int seg = bwt_segment(n, streams);
+    for (int j = 0; j < n; j++) {
+        int p = sa[j];
+        if (p == 0) *primary = j;
+        else if (streams > 1 && p % seg == 0) anchors[p / seg - 1] = j;
+        out[j] = in[p == 0 ? n - 1 : p - 1];
+    }
+}
+
+// BWT 정방향: 순환 회전을 prefix doubling + 기수 정렬로 정렬 (O(n log n))
+// out 에는 정렬된 회전의 마지막 문자열, *primary 에는 원본 회전의 행 번호
+// anchors 에는 줄기 streams 개로 역변환할 때의 시작 행 (streams 가 1 이면 쓰지 않음)
+// work 는 BWT_WORK_BYTES(n) 바이트 (스레드별 풀에서 재사용)
+static inline int bwt_encode_ws(const uint8_t* in, uint8_t* out, int n, int* primary,
+    int* anchors, int streams, void* work) {
+    if (n <= 0) {
+        *primary = 0;
+        return 0;
+    }
+    uint8_t* cur = work;
+    int* sa = codec_carve(&cur, sizeof(int) * n);
+    int* rank = codec_carve(&cur, sizeof(int) * n);
+    int* tmp = codec_carve(&cur, sizeof(int) * n);
+    int* cnt = codec_carve(&cur, sizeof(int) * (n > 256 ? n : 256));
+
+    // 첫 글자 기준 계수 정렬
+    memset(cnt, 0, sizeof(int) * 256);
+    for (int i = 0; i < n; i++) cnt[in[i]]++;
+    for (int c = 1; c < 256; c++) cnt[c] += cnt[c - 1];
+    for (int i = n - 1; i >= 0; i--) sa[--cnt[in[i]]] = i;
+    rank[sa[0]] = 0;
+    int classes = 1;
+    for (int j = 1; j < n; j++) {
+        if (in[sa[j]] != in[sa[j - 1]]) classes++;
+        rank[sa[j]] = classes - 1;
+    }
+
+    // 길이 k 로 정렬된 상태에서 (rank[i], rank[i+k]) 로 2k 정렬
+    for (int k = 1; k < n && classes < n; k <<= 1) {
+        for (int j = 0; j < n; j++) {
+            int p = sa[j] - k;
+            tmp[j] = p < 0 ? p + n : p;
+        }
+        memset(cnt, 0, sizeof(int) * classes);
+        for (int j = 0; j < n; j++) cnt[rank[tmp[j]]]++;
+        for (int c = 1; c < classes; c++) cnt[c] += cnt[c - 1];
+        for (int j = n - 1; j >= 0; j--) sa[--cnt[rank[tmp[j]]]] = tmp[j];
+
+        tmp[sa[0]] = 0;
+        classes = 1;
+        for (int j = 1; j < n; j++) {
+            int a = sa[j], b = sa[j - 1];
+            int a2 = a + k >= n ? a + k - n : a + k;
+            int b2 = b + k >= n ? b + k - n : b + k;
+            if (rank[a] != rank[b] || rank[a2] != rank[b2]) classes++;
+            tmp[a] = classes - 1;
+        }
+        int* swap = rank; rank = tmp; tmp = swap;
+    }
+
+    // 끝까지 같은 회전(주기 문자열)은 위치 순으로 정렬해서 병렬 버전과 결과를 맞춤
+    if (classes < n) {
+        for (int s = 0, e; s < n; s = e) {
+            for (e = s + 1; e < n && rank[sa[e]] == rank[sa[s]]; e++) {}
+            if (e - s > 1) qsort(sa + s, e - s, sizeof(int), bwt_cmp_int);
+        }
+    }
+
+    bwt_emit(in, sa, out, n, primary, anchors, streams);
+    return 0;
+}
+
+static inline int bwt_encode(const uint8_t* in, uint8_t* out, int n, int* primary, int* anchors, int streams) {
+    void* work = malloc(BWT_WORK_BYTES(n));
+    if (!work) return -1;
+    int rc = bwt_encode_ws(in, out, n, primary, anchors, streams, work);
+    free(work);
+    return rc;
+}
+
+// BWT 역변환 (한 줄기, 행 번호와 심볼을 따로 읽음): LF-mapping 을 따라 뒤에서부터 복원
+// BWT_PACKED_MAX 보다 큰 블록용, 벤치마크 기준선
+static inline int bwt_decode_lf(const uint8_t* in, uint8_t* out, int n, int primary) {
+    if (n <= 0) return 0;
+    if (primary < 0 || primary >= n) return -1;
+    int* lf = malloc(sizeof(int) * n);
+    if (!lf) return -1;
+
+    int C[256] = {0}, seen[256] = {0};
+    for (int i = 0; i < n; i++) C[in[i]]++;
+    for (int c = 0, sum = 0; c < 256; c++) {
+        int t = C[c];
+        C[c] = sum;
+        sum += t;
+    }
+    for (int i = 0; i < n; i++) lf[i] = C[in[i]] + seen[in[i]]++;
+
+    int p = primary;
+    for (int i = n - 1; i >= 0; i--) {
+        out[i] = in[p];
+        p = lf[p];
+    }
+    free(lf);
+    return 0;
+}
+
+// BWT 역변환 (여러 줄기): 행마다 (다음 행 << 8 | 심볼) 32비트 하나라서 한 걸음이 적재 한 번이고,
+// 줄기들을 번갈아 한 걸음씩 진행하므로 캐시 미스 여러 개가 동시에 진행됨
+// anchors 는 streams - 1 개 (streams 가 1 이면 NULL 가능). 앵커가 잘못되면 -1
+static inline int bwt_decode_streams(const uint8_t* in, uint8_t* out, int n, int primary,
+    const int* anchors, int streams) {
+    if (n <= 0) return 0;
+    if (primary < 0 || primary >= n) return -1;
+    if (n > BWT_PACKED_MAX) return bwt_decode_lf(in, out, n, primary);  // 앵커는 무시
+    if (streams < 1 || streams > BWT_MAX_STREAMS) return -1;
+    int seg = bwt_segment(n, streams);
+    if ((long long)(streams - 1) * seg >= n) return -1;
+    int row[BWT_MAX_STREAMS], pos[BWT_MAX_STREAMS];
+    for (int k = 0; k < streams; k++) {
+        row[k] = k == streams - 1 ? primary : anchors[k];
+        if (row[k] < 0 || row[k] >= n) return -1;
+        pos[k] = (k == streams - 1 ? n : (k + 1) * seg) - 1;
+    }
+    uint32_t* t = malloc(sizeof(uint32_t) * n);
+    if (!t) return -1;
+
+    int C[256] = {0};
+    for (int i = 0; i < n; i++) C[in[i]]++;
+    for (int c = 0, sum = 0; c < 256; c++) {
+        int x = C[c];
+        C[c] = sum;
+        sum += x;
+    }
+    for (int i = 0; i < n; i++) t[i] = (uint32_t)C[in[i]]++ << 8 | in[i];
+
+    // 모든 줄기가 마지막 줄기 길이만큼 함께, 그 뒤 나머지 줄기가 한 걸음씩 더
+    int last = n - (streams - 1) * seg;
+    for (int s = 0; s < last; s++) {
+        for (int k = 0; k < streams; k++) {
+            uint32_t e = t[row[k]];
+            out[pos[k]--] = (uint8_t)e;
+            row[k] = e >> 8;
+        }
+    }
+    for (int s = last; s < seg; s++) {
+        for (int k = 0; k < streams - 1; k++) {
+            uint32_t e = t[row[k]];
+            out[pos[k]--] = (uint8_t)e;
+            row[k] = e >> 8;
+        }
+    }
+    free(t);
+    return 0;
+}
+
+// 앵커 없는 블록 (한 줄기)
+static inline int bwt_decode(const uint8_t* in, uint8_t* out, int n, int primary) {
+    return bwt_decode_streams(in, out, n, primary, NULL, 1);
+}
+
+// ── 병렬 BWT: 첫 2바이트 기수 버킷 + 그룹별 병렬 정제 ──
+// 작업을 항목 단위로 나눠 runner 에 넘기면 runner 가 여러 스레드로 실행
+
+typedef void (*par_fn)(void* ctx, int item);
+typedef void (*par_runner)(par_fn fn, void* ctx, int items);
+
+#define PAR_BWT_MAX_CHUNKS 16
+
+// bwt_encode_parallel_ws 에 필요한 작업 메모리
+#define PAR_BWT_WORK_BYTES(n) (2 * (sizeof(uint64_t) * (size_t)(n) + 64) + \
+    5 * (sizeof(int) * ((size_t)(n) + 2) + 64) + sizeof(int) * 65536 * (PAR_BWT_MAX_CHUNKS + 1) + 128)
+
+typedef struct {
+    const uint8_t* in;
+    int n;
+    int* sa;
+    int* rank;       // 그룹 시작 위치 (Larsson-Sadakane 방식의 순위)
+    int* new_rank;   // 이번 라운드에서 갱신된 순위
+    uint64_t* pairs; // 그룹 정렬용 (키 << 32 | 위치), 그룹 구간별로 나눠 씀
+    uint64_t* tmp;   // 기수 정렬 보조 버퍼 (pairs 와 같은 구간 사용)
+    int chunks, chunk_len;
+    int* counts;     // chunks * 65536
+    int* bucket_start;
+    int h;
+    int* groups;      // 아직 정렬되지 않은 그룹 [s, e) 쌍
+    int* next_groups;
+    int next_count;   // next_groups 에 채운 쌍 수 (atomic)
+} ParBwt;
+
+static inline int par_bwt_key(const ParBwt* p, int i) {
+    return (p->in[i] << 8) | p->in[i + 1 == p->n ? 0 : i + 1];
+}
+
+// 청크별 2바이트 키 히스토그램
+static inline void par_bwt_count(void* ctx, int c) {
+    ParBwt* p = ctx;
+    int* cnt = p->counts + (size_t)c * 65536;
+    int s = c * p->chunk_len, e = s + p->chunk_len < p->n ? s + p->chunk_len : p->n;
+    memset(cnt, 0, sizeof(int) * 65536);
+    for (int i = s; i < e; i++) cnt[par_bwt_key(p, i)]++;
+}
+
+// 청크별 오프셋으로 흩뿌림 (버킷 안에서는 위치 순서 유지)
+static inline void par_bwt_scatter(void* ctx, int c) {
+    ParBwt* p = ctx;
+    int* off = p->counts + (size_t)c * 65536;
+    int s = c * p->chunk_len, e = s + p->chunk_len < p->n ? s + p->chunk_len : p->n;
+    for (int i = s; i < e; i++) {
+        int k = par_bwt_key(p, i);
+        p->sa[off[k]++] = i;
+        p->rank[i] = p->bucket_start[k];
+    }
+}
+
+static inline int par_bwt_cmp(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// 상위 32비트 키로 안정 정렬: 작은 그룹은 삽입 정렬, 큰 그룹은 LSD 기수 정렬
+static inline void par_bwt_sort(uint64_t* a, uint64_t* tmp, int len) {
+    if (len < 64) {
+        for (int i = 1; i < len; i++) {
+            uint64_t v = a[i];
+            int j = i - 1;
+            while (j >= 0 && (a[j] >> 32) > (v >> 32)) {
+                a[j + 1] = a[j];
+                j--;
+            }
+            a[j + 1] = v;
+        }
+        return;
+    }
+    int cnt[256];
+    for (int shift = 32; shift < 64; shift += 8) {
+        memset(cnt, 0, sizeof(cnt));
+        for (int i = 0; i < len; i++) cnt[(a[i] >> shift) & 255]++;
+        if (cnt[(a[0] >> shift) & 255] == len) continue;  // 이 바이트는 모두 같음
+        for (int c = 0, sum = 0; c < 256; c++) {
+            int t = cnt[c];
+            cnt[c] = sum;
+            sum += t;
+        }
+        for (int i = 0; i < len; i++) tmp[cnt[(a[i] >> shift) & 255]++] = a[i];
+        memcpy(a, tmp, sizeof(uint64_t) * len);
+    }
+}
+
+// 그룹 하나를 rank[i + h] 로 정렬하고 하위 그룹의 새 순위를 기록
+static inline void par_bwt_refine(void* ctx, int g) {
+    ParBwt* p = ctx;
+    int s = p->groups[2 * g], e = p->groups[2 * g + 1];
+    int n = p->n, h = p->h;
+    uint64_t* pr = p->pairs + s;
+    for (int j = s; j < e; j++) {
+        int x = p->sa[j];
+        int y = x + h >= n ? (x + h) % n : x + h;
+        pr[j - s] = ((uint64_t)p->rank[y] << 32) | (uint32_t)x;
+    }
+    par_bwt_sort(pr, p->tmp + s, e - s);
+    int start = s;
+    for (int j = s; j < e; j++) {
+        p->sa[j] = (int)(uint32_t)pr[j - s];
+        if (j > s && (pr[j - s] >> 32) != (pr[j - s - 1] >> 32)) {
+            if (j - start > 1) {
+                int slot = __atomic_fetch_add(&p->next_count, 1, __ATOMIC_RELAXED);
+                p->next_groups[2 * slot] = start;
+                p->next_groups[2 * slot + 1] = j;
+            }
+            start = j;
+        }
+        p->new_rank[p->sa[j]] = start;
+    }
+    if (e - start > 1) {
+        int slot = __atomic_fetch_add(&p->next_count, 1, __ATOMIC_RELAXED);
+        p->next_groups[2 * slot] = start;
+        p->next_groups[2 * slot + 1] = e;
+    }
+}
+
+// 라운드가 끝난 뒤 그룹 구간의 새 순위를 반영
+static inline void par_bwt_commit(void* ctx, int g) {
+    ParBwt* p = ctx;
+    for (int j = p->groups[2 * g]; j < p->groups[2 * g + 1]; j++)
+        p->rank[p->sa[j]] = p->new_rank[p->sa[j]];
+}
+
+// 끝까지 같은 회전(주기 문자열)은 위치 순으로 고정해서 결과를 결정적으로
+static inline void par_bwt_tiebreak(void* ctx, int g) {
+    ParBwt* p = ctx;
+    int s = p->groups[2 * g], e = p->groups[2 * g + 1];
+    for (int j = s; j < e; j++) p->pairs[j] = (uint32_t)p->sa[j];
+    qsort(p->pairs + s, e - s, sizeof(uint64_t), par_bwt_cmp);
+    for (int j = s; j < e; j++) p->sa[j] = (int)p->pairs[j];
+}
+
+// 병렬 BWT 정방향: 결과는 실행 스레드 수와 무관하게 동일
+// work 는 PAR_BWT_WORK_BYTES(n) 바이트
+static inline int bwt_encode_parallel_ws(const uint8_t* in, uint8_t* out, int n, int* primary,
+    int* anchors, int streams, par_runner run, void* work) {
+    if (n < 2) return bwt_encode_ws(in, out, n, primary, anchors, streams, work);
+    ParBwt p;
+    memset(&p, 0, sizeof(p));
+    p.in = in;
+    p.n = n;
+    p.chunks = n / 65536 < 1 ? 1 : n / 65536 > PAR_BWT_MAX_CHUNKS ? PAR_BWT_MAX_CHUNKS : n / 65536;
+    p.chunk_len = (n + p.chunks - 1) / p.chunks;
+    uint8_t* cur = work;
+    p.pairs = codec_carve(&cur, sizeof(uint64_t) * n);
+    p.tmp = codec_carve(&cur, sizeof(uint64_t) * n);
+    p.sa = codec_carve(&cur, sizeof(int) * n);
+    p.rank = codec_carve(&cur, sizeof(int) * n);
+    p.new_rank = codec_carve(&cur, sizeof(int) * n);
+    p.groups = codec_carve(&cur, sizeof(int) * (n + 2));
+    p.next_groups = codec_carve(&cur, sizeof(int) * (n + 2));
+    p.counts = codec_carve(&cur, sizeof(int) * 65536 * p.chunks);
+    p.bucket_start = codec_carve(&cur, sizeof(int) * 65536);
+
+    // 1) 첫 2바이트 기수 버킷 (청크별 히스토그램 → 전역 오프셋 → 흩뿌리기)
+    run(par_bwt_count, &p, p.chunks);
+    int ngroups = 0;
+    for (int k = 0, pos = 0; k < 65536; k++) {
+        p.bucket_start[k] = pos;
+        for (int c = 0; c < p.chunks; c++) {
+            int t = p.counts[(size_t)c * 65536 + k];
+            p.counts[(size_t)c * 65536 + k] = pos;
+            pos += t;
+        }
+        if (pos - p.bucket_start[k] > 1) {
+            p.groups[2 * ngroups] = p.bucket_start[k];
+            p.groups[2 * ngroups + 1] = pos;
+            ngroups++;
+        }
+    }
+    run(par_bwt_scatter, &p, p.chunks);
+
+    // 2) 정렬되지 않은 그룹만 2배 길이 키로 병렬 정제
+    for (p.h = 2; ngroups > 0; p.h = p.h > n / 2 ? n : p.h * 2) {
+        if (p.h >= n) {
+            run(par_bwt_tiebreak, &p, ngroups);
+            break;
+        }
+        p.next_count = 0;
+        run(par_bwt_refine, &p, ngroups);
+        run(par_bwt_commit, &p, ngroups);
+        int* t = p.groups; p.groups = p.next_groups; p.next_groups = t;
+        ngroups = p.next_count;
+    }
+
+    bwt_emit(in, p.sa, out, n, primary, anchors, streams);
+    return 0;
+}
+
+static inline int bwt_encode_parallel(const uint8_t* in, uint8_t* out, int n, int* primary,
+    int* anchors, int streams, par_runner run) {
+    void* work = malloc(PAR_BWT_WORK_BYTES(n));
+    if (!work) return -1;
+    int rc = bwt_encode_parallel_ws(in, out, n, primary, anchors, streams, run, work);
+    free(work);
+    return rc;
+}
+
+// Move-To-Front (제자리 변환)
+static inline void mtf_encode(uint8_t* buf, int n) {
+    uint8_t order[256];
+    for (int i = 0; i < 256; i++) order[i] = (uint8_t)i;
+    for (int i = 0; i < n; i++) {
+        uint8_t c = buf[i];
+        int j = 0;
+        while (order[j] != c) j++;
+        memmove(order + 1, order, j);
+        order[0] = c;
+        buf[i] = (uint8_t)j;
+    }
+}
+
+static inline void mtf_decode(uint8_t* buf, int n) {
+    uint8_t order[256];
+    for (int i = 0; i < 256; i++) order[i] = (uint8_t)i;
+    for (int i = 0; i < n; i++) {
+        int j = buf[i];
+        uint8_t c = order[j];
+        memmove(order + 1, order, j);
+        order[0] = c;
+        buf[i] = c;
+    }
+}
+
+// RLE: 같은 바이트가 4번 이상 이어지면 4바이트 + 추가 반복 횟수(0~255)
+static inline int rle_encode(const uint8_t* in, int n, uint8_t* out) {
+    int o = 0;
+    for (int i = 0; i < n;) {
+        uint8_t c = in[i];
+        int run = 1;
+        while (i + run < n && in[i + run] == c && run < 259) run++;
+        if (run >= 4) {
+            out[o++] = c; out[o++] = c; out[o++] = c; out[o++] = c;
+            out[o++] = (uint8_t)(run - 4);
+        } else {
+            for (int k = 0; k < run; k++) out[o++] = c;
+        }
+        i += run;
+    }
+    return o;
+}
+
+// 복원된 길이를 반환, out_cap 을 넘거나 입력이 잘리면 -1
+static inline int rle_decode(const uint8_t* in, int n, uint8_t* out, int out_cap) {
+    int o = 0, last = -1, run = 0;
+    for (int i = 0; i < n;) {
+        uint8_t c = in[i++];
+        if (o >= out_cap) return -1;
+        out[o++] = c;
+        if (c == last) {
+            run++;
+        } else {
+            last = c;
+            run = 1;
+        }
+        if (run == 4) {
+            if (i >= n) return -1;
+            int extra = in[i++];
+            if (o + extra > out_cap) return -1;
+            memset(out + o, c, extra);
+            o += extra;
+            last = -1;
+            run = 0;
+        }
+    }
+    return o;
+}
+
+// ── Huffman: RLE 출력의 엔트로피 부호화 ──
+// 큰 입력은 HUF_CHUNK 단위로 나눠서 청크별 히스토그램 → 공통 코드 →
+// 청크별 비트 길이의 prefix sum 으로 시작 비트를 정하고 병렬 부호화.
+// 결과는 한 번에 직렬로 부호화한 것과 바이트 단위로 같음
+
+#define HUF_MAX_BITS 12
+#define HUF_CHUNK (64 * 1024)
+#define HUF_HEADER (4 + 128)  // u32 심볼 수 + 256개 코드 길이 (4비트씩)
+
+// 바이트 히스토그램: 4개의 표에 번갈아 세어서 같은 카운터의 연속 증가가
+// 저장→적재 의존성으로 줄 서지 않게 함 (AVX2 에는 충돌 검출이 없어서
+// 흩어진 증가를 벡터화해도 이득이 없으므로 스칼라 8바이트 적재로 처리)
+static inline void huf_histogram(const uint8_t* in, int n, uint32_t freq[256]) {
+    uint32_t t[4][256];
+    memset(t, 0, sizeof(t));
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v;
+        memcpy(&v, in + i, 8);
+        t[0][v & 255]++;
+        t[1][(v >> 8) & 255]++;
+        t[2][(v >> 16) & 255]++;
+        t[3][(v >> 24) & 255]++;
+        t[0][(v >> 32) & 255]++;
+        t[1][(v >> 40) & 255]++;
+        t[2][(v >> 48) & 255]++;
+        t[3][v >> 56]++;
+    }
+    for (; i < n; i++) t[0][in[i]]++;
+    for (int c = 0; c < 256; c++) freq[c] = t[0][c] + t[1][c] + t[2][c] + t[3][c];
+}
+
+// 빈도 → 코드 길이 (허프만 트리 후 HUF_MAX_BITS 로 제한)
+static inline void huf_build_lengths(const uint32_t freq[256], uint8_t len[256]) {
+    uint64_t w[512];
+    int parent[512], alive[512];
+    int nodes = 256, used = 0, last = 0;
+    memset(len, 0, 256);
+    for (int c = 0; c < 256; c++) {
+        w[c] = freq[c];
+        alive[c] = freq[c] > 0;
+        parent[c] = -1;
+        if (freq[c]) {
+            used++;
+            last = c;
+        }
+    }
+    if (used == 0) return;
+    if (used == 1) {
+        len[last] = 1;
+        return;
+    }
+    for (int k = used; k > 1; k--) {
+        int a = -1, b = -1;
+        for (int i = 0; i < nodes; i++) {
+            if (!alive[i]) continue;
+            if (a < 0 || w[i] < w[a]) {
+                b = a;
+                a = i;
+            } else if (b < 0 || w[i] < w[b]) {
+                b = i;
+            }
+        }
+        w[nodes] = w[a] + w[b];
+        alive[nodes] = 1;
+        parent[nodes] = -1;
+        alive[a] = alive[b] = 0;
+        parent[a] = parent[b] = nodes;
+        nodes++;
+    }
+    for (int c = 0; c < 256; c++) {
+        if (!freq[c]) continue;
+        int d = 0;
+        for (int x = c; parent[x] >= 0; x = parent[x]) d++;
+        len[c] = d > HUF_MAX_BITS ? HUF_MAX_BITS : d;
+    }
+    // 잘라낸 뒤 Kraft 합이 넘치면 가장 긴(같으면 드문) 코드부터 한 비트씩 늘림
+    uint32_t kraft = 0;
+    for (int c = 0; c < 256; c++)
+        if (len[c]) kraft += 1u << (HUF_MAX_BITS - len[c]);
+    while (kraft > (1u << HUF_MAX_BITS)) {
+        int pick = -1;
+        for (int c = 0; c < 256; c++) {
+            if (!len[c] || len[c] >= HUF_MAX_BITS) continue;
+            if (pick < 0 || len[c] > len[pick] || (len[c] == len[pick] && freq[c] < freq[pick])) pick = c;
+        }
+        kraft -= 1u << (HUF_MAX_BITS - len[pick] - 1);
+        len[pick]++;
+    }
+}
+
+// 정규(canonical) 코드 부여
+static inline void huf_build_codes(const uint8_t len[256], uint16_t code[256]) {
+    int bl_count[HUF_MAX_BITS + 1] = {0}, next[HUF_MAX_BITS + 2];
+    for (int c = 0; c < 256; c++) bl_count[len[c]]++;
+    bl_count[0] = 0;
+    int v = 0;
+    for (int b = 1; b <= HUF_MAX_BITS; b++) {
+        v = (v + bl_count[b - 1]) << 1;
+        next[b] = v;
+    }
+    for (int c = 0; c < 256; c++) code[c] = len[c] ? next[len[c]]++ : 0;
+}
+
+typedef struct {
+    const uint8_t* in;
+    int n;
+    uint8_t* out;           // 비트스트림 시작 (헤더 뒤)
+    int chunks;
+    uint32_t (*freq)[256];  // 청크별 히스토그램
+    uint64_t* bit_off;      // 청크별 시작 비트 (prefix sum)
+    uint8_t* head;          // 이전 청크와 나눠 쓰는 첫 바이트
+    uint8_t len[256];
+    uint16_t code[256];
+} HufJob;
+
+static inline void huf_count_chunk(void* ctx, int c) {
+    HufJob* j = ctx;
+    int s = c * HUF_CHUNK, e = s + HUF_CHUNK < j->n ? s + HUF_CHUNK : j->n;
+    huf_histogram(j->in + s, e - s, j->freq[c]);
+}
+
+// 청크 하나를 자기 시작 비트 위치에 부호화. 시작이 바이트 중간이면
+// 첫 바이트는 앞 청크 것과 겹치므로 head 에 두고 나중에 OR 로 합침
+static inline void huf_encode_chunk(void* ctx, int c) {
+    HufJob* j = ctx;
+    int s = c * HUF_CHUNK, e = s + HUF_CHUNK < j->n ? s + HUF_CHUNK : j->n;
+    uint64_t off = j->bit_off[c];
+    size_t pos = off / 8;
+    size_t first = pos;
+    int shared = off % 8 != 0;
+    uint64_t acc = 0;
+    int nbits = off % 8;
+    j->head[c] = 0;
+    for (int i = s; i < e; i++) {
+        uint8_t sym = j->in[i];
+        acc = (acc << j->len[sym]) | j->code[sym];
+        nbits += j->len[sym];
+        while (nbits >= 8) {
+            uint8_t byte = (uint8_t)(acc >> (nbits - 8));
+            nbits -= 8;
+            if (shared && pos == first) j->head[c] = byte;
+            else j->out[pos] = byte;
+            pos++;
+        }
+    }
+    if (nbits > 0) {
+        uint8_t byte = (uint8_t)(acc << (8 - nbits));
+        if (shared && pos == first) j->head[c] = byte;
+        else j->out[pos] = byte;
+    }
+}
+
+// 입력이 최대 max_n 바이트인 작업의 표 할당 (청크별 히스토그램은 0 으로), 실패하면 -1
+static inline int huf_alloc(HufJob* j, int max_n) {
+    int chunks = max_n > 0 ? (max_n + HUF_CHUNK - 1) / HUF_CHUNK : 0;
+    j->freq = calloc(chunks ? chunks : 1, sizeof(uint32_t[256]));
+    j->bit_off = malloc(sizeof(uint64_t) * (chunks + 1));
+    j->head = malloc(chunks ? chunks : 1);
+    return j->freq && j->bit_off && j->head ? 0 : -1;
+}
+
+// 청크별 히스토그램이 이미 채워진 상태에서 코드와 크기를 구함
+// (mtf_rle_encode 처럼 입력을 만들면서 센 경우 다시 훑지 않음)
+static inline size_t huf_plan_counted(HufJob* j, const uint8_t* in, int n) {
+    j->in = in;
+    j->n = n;
+    j->chunks = n > 0 ? (n + HUF_CHUNK - 1) / HUF_CHUNK : 0;
+    uint32_t total[256] = {0};
+    for (int c = 0; c < j->chunks; c++)
+        for (int s = 0; s < 256; s++) total[s] += j->freq[c][s];
+    huf_build_lengths(total, j->len);
+    huf_build_codes(j->len, j->code);
+
+    j->bit_off[0] = 0;
+    for (int c = 0; c < j->chunks; c++) {
+        uint64_t bits = 0;
+        for (int s = 0; s < 256; s++) bits += (uint64_t)j->freq[c][s] * j->len[s];
+        j->bit_off[c + 1] = j->bit_off[c] + bits;
+    }
+    return HUF_HEADER + (j->bit_off[j->chunks] + 7) / 8;
+}
+
+// 부호화 결과 크기 (헤더 포함). 원본보다 이득이 없으면 호출 측이 다른 방식 선택
+// huf_plan 으로 코드와 크기를 먼저 구하고 huf_encode 로 실제 기록
+static inline size_t huf_plan(HufJob* j, const uint8_t* in, int n, par_runner run) {
+    if (huf_alloc(j, n) < 0) return (size_t)-1;
+    j->in = in;
+    j->n = n;
+    j->chunks = n > 0 ? (n + HUF_CHUNK - 1) / HUF_CHUNK : 0;
+    run(huf_count_chunk, j, j->chunks);
+    return huf_plan_counted(j, in, n);
+}
+
+static inline void huf_encode(HufJob* j, uint8_t* out, par_runner run) {
+    out[0] = j->n; out[1] = j->n >> 8; out[2] = j->n >> 16; out[3] = j->n >> 24;
+    for (int s = 0; s < 256; s += 2) out[4 + s / 2] = (j->len[s] << 4) | j->len[s + 1];
+    j->out = out + HUF_HEADER;
+    run(huf_encode_chunk, j, j->chunks);
+    for (int c = 1; c < j->chunks; c++)
+        if (j->bit_off[c] % 8) j->out[j->bit_off[c] / 8] |= j->head[c];
+}
+
+static inline void huf_free(HufJob* j) {
+    free(j->freq);
+    free(j->bit_off);
+    free(j->head);
+}
+
+// MTF + RLE 를 한 번에: BWT 출력을 읽으며 MTF 심볼을 바로 런으로 묶어 out 에 씀
+// 결과는 mtf_encode 후 rle_encode 한 것과 바이트 단위로 같음 (중간 버퍼 없음)
+// freq 가 있으면 출력 바이트를 HUF_CHUNK 단위 청크별로 세어 둠 (Huffman 히스토그램 단계 생략)
+// BWT 출력의 같은 바이트 런은 MTF 에서 0 의 런이 되므로 대부분 맨 앞 비교 한 번으로 끝남
+static inline int mtf_rle_encode(const uint8_t* in, int n, uint8_t* out, uint32_t (*freq)[256]) {
+    uint8_t order[256];
+    for (int i = 0; i < 256; i++) order[i] = (uint8_t)i;
+    int o = 0;
+    for (int i = 0; i < n;) {
+        // 런의 첫 심볼
+        uint8_t c = in[i];
+        int j = 0;
+        while (order[j] != c) j++;
+        memmove(order + 1, order, j);
+        order[0] = c;
+        uint8_t sym = (uint8_t)j;
+        int run = 1;
+        i++;
+        if (sym == 0) {
+            // 0 이 이어지는 동안은 원본도 같은 바이트 (order 는 그대로)
+            while (i < n && in[i] == c && run < 259) {
+                i++;
+                run++;
+            }
+        } else {
+            // 0 이 아닌 같은 심볼의 런 (예: abab → 1 1 1 1)
+            while (i < n && run < 259) {
+                uint8_t d = in[i];
+                if (order[sym] != d) break;
+                memmove(order + 1, order, sym);
+                order[0] = d;
+                i++;
+                run++;
+            }
+        }
+        int emit = run >= 4 ? 4 : run;
+        for (int k = 0; k < emit; k++) out[o + k] = sym;
+        if (run >= 4) out[o + 4] = (uint8_t)(run - 4);
+        if (freq) {
+            for (int k = 0; k < emit; k++)
+                freq[(o + k) / HUF_CHUNK][sym]++;
+            if (run >= 4) freq[(o + 4) / HUF_CHUNK][run - 4]++;
+        }
+        o += emit + (run >= 4);
+    }
+    return o;
+}
+
+// 복원: 12비트 단일 조회표. 심볼 수를 반환, 손상되면 -1
+static inline int huf_decode(const uint8_t* in, int n, uint8_t* out, int out_cap) {
+    if (n < HUF_HEADER) return -1;
+    int count = in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+    if (count < 0 || count > out_cap) return -1;
+    uint8_t len[256];
+    uint16_t code[256];
+    for (int s = 0; s < 256; s += 2) {
+        len[s] = in[4 + s / 2] >> 4;
+        len[s + 1] = in[4 + s / 2] & 15;
+    }
+    uint32_t kraft = 0;
+    for (int s = 0; s < 256; s++) {
+        if (len[s] > HUF_MAX_BITS) return -1;
+        if (len[s]) kraft += 1u << (HUF_MAX_BITS - len[s]);
+    }
+    if (kraft > (1u << HUF_MAX_BITS)) return -1;
+    huf_build_codes(len, code);
+
+    uint16_t* table = calloc(1 << HUF_MAX_BITS, sizeof(uint16_t));
+    if (!table) return -1;
+    for (int s = 0; s < 256; s++) {
+        if (!len[s]) continue;
+        int shift = HUF_MAX_BITS - len[s];
+        for (int k = 0; k < (1 << shift); k++)
+            table[(code[s] << shift) | k] = (uint16_t)(s | (len[s] << 8));
+    }
+
+    const uint8_t* p = in + HUF_HEADER;
+    const uint8_t* end = in + n;
+    uint64_t acc = 0;
+    int nbits = 0;
+    for (int i = 0; i < count; i++) {
+        while (nbits <= 56) {
+            acc = (acc << 8) | (p < end ? *p : 0);
+            p++;
+            nbits += 8;
+        }
+        uint16_t t = table[(acc >> (nbits - HUF_MAX_BITS)) & ((1 << HUF_MAX_BITS) - 1)];
+        int l = t >> 8;
+        if (l == 0 || (p - end) * 8 > nbits - l) {
+            free(table);
+            return -1;
+        }
+        out[i] = (uint8_t)t;
+        nbits -= l;
+    }
+    free(table);
+    return count;
+}
+
+// ── RAW 블록 판별과 빠른 LZ 경로 ──
+
+#define PROBE_WINDOW 4096  // 표본 창 크기
+#define PROBE_WINDOWS 16   // 블록에서 고르게 뽑는 창 수
+#define PROBE_HASH_BITS 12
+
+typedef struct {
+    double bits;   // order-0 엔트로피 추정 (비트/바이트)
+    double match;  // 앞에서 본 4바이트가 다시 나오는 위치의 비율
+} Probe;
+
+// 블록 전체 대신 표본만 보고 압축 가능성을 추정 (BWT 비용의 극히 일부)
+static inline Probe probe_block(const uint8_t* in, int n) {
+    Probe p = { 0.0, 0.0 };
+    if (n <= 0) return p;
+    int windows = n <= PROBE_WINDOW * PROBE_WINDOWS ? 1 : PROBE_WINDOWS;
+    int win = windows == 1 ? n : PROBE_WINDOW;
+    long step = windows == 1 ? 0 : (long)(n - win) / (windows - 1);
+    uint32_t freq[256] = {0}, f[256];
+    int table[1 << PROBE_HASH_BITS];
+    memset(table, -1, sizeof(table));
+    long sampled = 0, probes = 0, matches = 0;
+    for (int w = 0; w < windows; w++) {
+        const uint8_t* s = in + w * step;
+        huf_histogram(s, win, f);
+        for (int c = 0; c < 256; c++) freq[c] += f[c];
+        sampled += win;
+        for (int i = 0; i + 4 <= win; i++) {
+            uint32_t v;
+            memcpy(&v, s + i, 4);
+            uint32_t h = (v * 2654435761u) >> (32 - PROBE_HASH_BITS);
+            int pos = (int)(s - in) + i;
+            if (table[h] >= 0 && memcmp(in + table[h], s + i, 4) == 0) matches++;
+            table[h] = pos;
+            probes++;
+        }
+    }
+    for (int c = 0; c < 256; c++) {
+        if (!freq[c]) continue;
+        double q = (double)freq[c] / sampled;
+        p.bits -= q * log2(q);
+    }
+    p.match = probes ? (double)matches / probes : 0.0;
+    return p;
+}
+
+// LZ4 와 같은 계열의 바이트 정렬 LZ77: 토큰(리터럴 길이 4비트 | 매치 길이-4 4비트),
+// 15 이상은 255 단위 확장 바이트, 오프셋 u16 LE. 마지막 시퀀스는 리터럴만
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 14
+#define LZ_MAX_OFF 65535
+
+static inline uint8_t* lz_put_len(uint8_t* op, const uint8_t* oend, int len) {
+    for (; len >= 255; len -= 255) {
+        if (op >= oend) return NULL;
+        *op++ = 255;
+    }
+    if (op >= oend) return NULL;
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static inline uint8_t* lz_put_seq(uint8_t* op, const uint8_t* oend, const uint8_t* lit, int lit_len, int off, int mlen) {
+    if (op >= oend) return NULL;
+    uint8_t* tok = op++;
+    *tok = (uint8_t)((lit_len < 15 ? lit_len : 15) << 4);
+    if (lit_len >= 15 && !(op = lz_put_len(op, oend, lit_len - 15))) return NULL;
+    if (op + lit_len > oend) return NULL;
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (mlen == 0) return op;
+    int m = mlen - LZ_MIN_MATCH;
+    *tok |= (uint8_t)(m < 15 ? m : 15);
+    if (op + 2 > oend) return NULL;
+    *op++ = (uint8_t)off;
+    *op++ = (uint8_t)(off >> 8);
+    if (m >= 15 && !(op = lz_put_len(op, oend, m - 15))) return NULL;
+    return op;
+}
+
+// greedy 한 번 훑기. out_cap 을 넘으면 -1 (이득 없음)
+static inline int lz_encode(const uint8_t* in, int n, uint8_t* out, int out_cap) {
+    int table[1 << LZ_HASH_BITS];
+    memset(table, -1, sizeof(table));
+    uint8_t* op = out;
+    const uint8_t* oend = out + out_cap;
+    int anchor = 0, i = 0;
+    while (i + LZ_MIN_MATCH <= n) {
+        uint32_t v;
+        memcpy(&v, in + i, 4);
+        uint32_t h = (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+        int cand = table[h];
+        table[h] = i;
+        if (cand < 0 || i - cand > LZ_MAX_OFF || memcmp(in + cand, in + i, 4) != 0) {
+            i++;
+            continue;
+        }
+        int len = LZ_MIN_MATCH;
+        while (i + len < n && in[cand + len] == in[i + len]) len++;
+        if (!(op = lz_put_seq(op, oend, in + anchor, i - anchor, i - cand, len))) return -1;
+        i += len;
+        anchor = i;
+    }
+    if (!(op = lz_put_seq(op, oend, in + anchor, n - anchor, 0, 0))) return -1;
+    return (int)(op - out);
+}
+
+static inline int lz_get_len(const uint8_t** ip, const uint8_t* iend, int* len) {
+    uint8_t b;
+    do {
+        if (*ip >= iend) return -1;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+// 복원된 길이를 반환, 손상되면 -1
+static inline int lz_decode(const uint8_t* in, int n, uint8_t* out, int out_cap) {
+    const uint8_t* ip = in, * iend = in + n;
+    uint8_t* op = out;
+    while (ip < iend) {
+        uint8_t tok = *ip++;
+        int lit = tok >> 4;
+        if (lit == 15 && lz_get_len(&ip, iend, &lit) < 0) return -1;
+        if (lit > iend - ip || lit > out + out_cap - op) return -1;
+        memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == iend) break;
+        if (iend - ip < 2) return -1;
+        int off = ip[0] | (ip[1] << 8);
+        ip += 2;
+        int mlen = tok & 15;
+        if (mlen == 15 && lz_get_len(&ip, iend, &mlen) < 0) return -1;
+        mlen += LZ_MIN_MATCH;
+        if (off == 0 || off > op - out || mlen > out + out_cap - op) return -1;
+        for (int k = 0; k < mlen; k++, op++) *op = op[-off];
+    }
+    return (int)(op - out);
+}
+
+#endif
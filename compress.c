@@ -0,0 +1,1808 @@
+// compress.c — stdin → stdout 스트리밍 압축 (실제 BWT → MTF → RLE)
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#include "result.h"
+#include "codec.h"
+#include "uring.h"
+#include "hash.h"
+#include "hugepool.h"
+#include "crc32c.h"
+#include "walk.h"
+
+#define DEFAULT_BLOCK_KB 256      // 기본 블록 크기 (KB)
+#define MAX_BLOCK_KB (64 * 1024)  // 블록 크기 상한 (64 MB)
+#define INFLIGHT_PER_THREAD 2     // 스레드당 동시에 떠 있는 블록 수
+#define IO_READERS 2              // io_uring 미지원 시 pread 스레드 수
+#define PAR_BWT_MIN (1 << 20)     // 이 크기 이상 블록은 유휴 워커와 나눠서 BWT
+#define PROBE_STORED_BITS 7.9     // 표본 엔트로피가 이 이상이고
+#define PROBE_STORED_MATCH 0.005  // 4바이트 반복 비율이 이 미만이면 바로 stored
+#define PROBE_LZ_BITS 6.0         // -L: 이 이상이면 BWT 대신 빠른 LZ
+#define STREAM_MAGIC "PFC2"         // 블록 헤더에 원본 CRC32C 포함
+#define LEGACY_MAGIC "PFC1"         // 체크섬 없는 이전 형식 (해제만 지원)
+#define BLOCK_HEADER 17             // u32 원본 길이, u8 방식, u32 primary, u32 페이로드 길이, u32 CRC32C
+#define LEGACY_HEADER 13
+#define CRC_BENCH_BYTES (64 << 20)  // -K 벤치마크 버퍼
+#define MANIFEST_HEADER "# pfc manifest v1"
+#define INDEX_MAGIC "PFCI"          // 아카이브 끝 표시 뒤의 파일 색인
+#define INDEX_TAIL_MAGIC "PFCX"
+#define INDEX_HEADER 8              // 매직, u32 파일 수
+#define INDEX_ENTRY 40              // u64 레코드 시작/끝, u64 원본 크기, u32 첫 블록 번호/블록 수/첫 블록 안 위치/이름 위치
+#define INDEX_TRAILER 16            // u64 색인 위치, u32 CRC32C, 매직 (파일 맨 끝)
+#define DISCOVERY_THREADS 4         // -a 디렉터리 탐색 스레드 수
+#define FILE_CHUNK 4096             // 파일/작업 계획 표는 청크 단위로 늘림
+#define PLAN_CHUNK 65536            // (탐색 중에 다른 스레드가 보는 항목의 주소가 바뀌지 않게)
+#define MAX_CHUNKS 65536
+
+// 블록의 처리 단계 정의 (HASH: 아카이브 모드의 파일 해시 작업, DECODE: 해제)
+typedef enum { RAW, BWT_DONE, MTF_DONE, DONE, HASH, DECODE } Stage;
+
+// 블록 저장 방식 (METHOD_COPY 는 이전 아카이브에서 복사, 디스크에 기록되지 않음)
+// METHOD_BWT: BWT+MTF+RLE, METHOD_BWT_HUF: 그 뒤에 Huffman 까지, METHOD_LZ: 빠른 LZ (-L)
+// METHOD_BWT_MS / METHOD_BWT_HUF_MS: 같은 내용 뒤에 역변환 앵커 (u32 앵커 * (줄기 수 - 1), u8 줄기 수)
+// METHOD_CORRUPT 는 해제 중 복원이나 체크섬 확인에 실패한 블록 표시 (역시 기록되지 않음)
+enum {
+    METHOD_STORED = 0, METHOD_BWT = 1, METHOD_BWT_HUF = 2, METHOD_LZ = 3,
+    METHOD_BWT_MS = 4, METHOD_BWT_HUF_MS = 5, METHOD_COPY = 255, METHOD_CORRUPT = -1
+};
+
+// 블록 구조체: 입력 순서, 단계, 두 개의 작업 버퍼
+typedef struct {
+    long seq;          // 입력 순서 번호 (출력 재정렬용)
+    int file;          // 아카이브 모드에서 속한 파일 번호
+    Stage stage;
+    int len;           // 원본 길이
+    int primary;       // BWT primary index
+    int streams;       // 역변환 줄기 수 (1 이면 앵커 없음)
+    int anchors[BWT_MAX_STREAMS - 1];
+    int method;
+    int out_len;       // 기록할 페이로드 길이
+    uint32_t crc;      // 원본의 CRC32C (압축: RAW 단계에서 계산, 해제: 헤더에서 읽음)
+    uint8_t* data;     // 현재 단계의 입력
+    uint8_t* work;     // 현재 단계의 출력
+    uint8_t* bufs[2];  // 슬롯이 소유한 두 버퍼 (io_uring 고정 버퍼 등록용)
+    size_t cap;        // 버퍼 하나의 크기 (해제 중 더 큰 블록이 오면 늘어남)
+    uint8_t hdr[BLOCK_HEADER];  // 블록 레코드 헤더
+    struct iovec iov[2];
+} Block;
+
+int block_size = DEFAULT_BLOCK_KB * 1024;
+int max_inflight = 0;
+size_t buf_cap = 0;
+
+// 파일 입출력 (-i/-o): 오프셋 기반으로 읽고 쓴다
+int fd_in = -1, fd_out = -1;
+int force_pread = 0;
+long long input_size = 0;
+off_t out_off = 0;
+long next_read = 0;
+int event_fd = -1;  // io_uring I/O 스레드에 워커 완료를 알리는 eventfd
+
+// 블록 슬롯 풀: max_inflight 개만 할당해서 스트림 길이와 무관하게 메모리 고정
+Block* slots;
+Block** free_slots;
+int free_count = 0;
+
+// 재정렬 버퍼: seq % max_inflight 자리에 완료된 블록을 둔다
+Block** reorder;
+long next_write = 0;
+long total_blocks = -1;  // EOF 전까지는 알 수 없음
+
+pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t slot_free = PTHREAD_COND_INITIALIZER;
+pthread_cond_t block_done = PTHREAD_COND_INITIALIZER;
+
+// 단계별 큐 (원형 버퍼, 용량 max_inflight)
+Block** raw_queue, ** bwt_queue, ** mtf_queue;
+long raw_head = 0, raw_tail = 0;
+long bwt_head = 0, bwt_tail = 0;
+long mtf_head = 0, mtf_tail = 0;
+int shutting_down = 0;
+
+pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
+
+long long bytes_in = 0, bytes_out = 0;
+
+// 해제 (-d): 블록을 워커 풀에서 병렬로 복원하고 writer 가 원본만 순서대로 기록
+// 추출 (-a -x): 색인에서 찾은 파일의 블록 레코드만 mmap 에서 같은 경로로 복원
+int decompressing = 0;
+const uint8_t* map_pos = NULL, * map_end = NULL;  // 추출 중 남은 레코드 범위 (NULL 이면 stdin)
+long long extract_skip = 0;  // 첫 블록에서 건너뛸 바이트
+long long extract_left = -1; // 남은 원본 바이트 (-1 이면 제한 없음)
+int stream_crc = 1;     // 입력 스트림에 블록 체크섬이 있는지 (PFC1 이면 0)
+long crc_verified = 0;  // 체크섬을 확인한 블록 수 (atomic)
+
+// BWT 작업 메모리: 워커마다 huge page 풀 하나를 미리 fault 시켜 두고 블록마다 재사용
+// (-H: hugetlbfs 먼저 시도, -M: 비교용으로 블록마다 malloc)
+enum { WORK_POOL, WORK_HUGETLB, WORK_MALLOC };
+int work_mode = WORK_POOL;
+int work_kind = -1;  // 실제로 잡힌 풀 종류 (HUGE_*), 요약 출력용
+static __thread HugeBuf worker_ws;
+static __thread HugeBuf worker_rle;  // RLE 스트림 (원본이 든 work 를 덮지 않게 따로 씀)
+
+// RAW 단계 판별 결과 (atomic 카운터)
+int fast_lz = 0;  // -L: 중간 정도로 압축되는 블록은 LZ 로
+int fused_mtf_rle = 0;  // -F: BWT 뒤의 MTF 와 RLE 를 한 단계로 (큐 왕복과 MTF 중간 결과 없음)
+long probe_stored = 0, probe_lz = 0;
+
+// 큰 블록의 BWT 를 유휴 워커가 거들 수 있게 공개하는 병렬 작업 (한 번에 하나)
+typedef struct {
+    par_fn fn;
+    void* ctx;
+    int items;
+    int next;     // 다음에 가져갈 항목 (atomic)
+    int helpers;  // 참여 중인 유휴 워커 수 (queue_mutex 로 보호)
+} HelpJob;
+
+HelpJob* help_job = NULL;
+int idle_workers = 0;  // 큐가 비어 대기 중인 워커 수
+pthread_cond_t helpers_left = PTHREAD_COND_INITIALIZER;
+
+// 아카이브 모드 (-a): 파일별 블록 범위와 내용 해시를 매니페스트로 남기고
+// 다음 실행에서 해시가 같은 파일은 이전 아카이브에서 그대로 복사
+// 디렉터리 인자는 탐색 스레드가 찾는 즉시 해시 단계로 흘려보내고,
+// 해시가 끝난 파일부터 (발견 순서대로) 블록 계획을 늘려서 리더가 바로 읽어 감
+typedef struct {
+    char* path;
+    int hashed;
+    long long size;
+    long long mtime;  // 수정 시각 (ns), 크기와 함께 이전 매니페스트와 같으면 해시를 다시 계산하지 않음
+    uint64_t hash;
+    long long prev_off, prev_end;  // 이전 아카이브 내 범위 (-1: 새로 압축)
+    long long arc_off, arc_end;    // 새 아카이브 내 범위
+    long nblocks;                  // 이 파일에 해당하는 블록 레코드 수
+} FileEntry;
+
+// 출력 순서(seq)별 작업: 파일의 한 블록을 압축하거나, 파일 전체를 복사
+typedef struct {
+    int file;
+    int copy;
+    int first, last;  // 파일의 첫/마지막 작업인지
+    long long src_off;
+    int len;
+} BlockPlan;
+
+// 아래 카운터와 청크 표의 확장은 pool_mutex 로 보호
+FileEntry* file_chunks[MAX_CHUNKS];
+BlockPlan* plan_chunks[MAX_CHUNKS];
+int archiving = 0;
+int file_count = 0;
+int next_plan = 0;          // 다음에 계획할 파일 (앞 파일들의 해시가 끝나야 진행)
+long planned_blocks = 0;    // 리더가 읽어 갈 수 있는 작업 수
+int unchanged_files = 0;
+int prev_fd = -1;
+struct timeval archive_start, first_block_time;  // 첫 블록이 큐에 들어간 시각
+pthread_cond_t discover_slot = PTHREAD_COND_INITIALIZER;  // 해시 작업에 쓸 슬롯을 기다리는 탐색 스레드
+
+Block** hash_queue;
+long hash_head = 0, hash_tail = 0;
+int hashes_done = 0;
+pthread_cond_t hash_done = PTHREAD_COND_INITIALIZER;
+
+typedef struct {
+    char* path;
+    uint64_t hash;
+    long long size, mtime, off, end;
+    long nblocks;
+} ManifestEntry;
+
+ManifestEntry* prev_ents = NULL;  // 이전 매니페스트 (경로순 정렬)
+int prev_count = 0;
+int rehash_skipped = 0;  // 크기와 수정 시각이 같아서 읽지 않은 파일 수
+
+static FileEntry* file_at(long i) {
+    return &file_chunks[i / FILE_CHUNK][i % FILE_CHUNK];
+}
+
+static BlockPlan* plan_at(long seq) {
+    return &plan_chunks[seq / PLAN_CHUNK][seq % PLAN_CHUNK];
+}
+
+// 청크 표에 항목 자리를 마련 (pool_mutex 를 잡고 호출), 표가 가득 차면 종료
+static void* chunk_slot(void** chunks, long i, long per_chunk, size_t size) {
+    long c = i / per_chunk;
+    if (c >= MAX_CHUNKS || (!chunks[c] && !(chunks[c] = calloc(per_chunk, size)))) {
+        fprintf(stderr, "Too many files or blocks for the archive plan.\n");
+        exit(1);
+    }
+    return (char*)chunks[c] + (i % per_chunk) * size;
+}
+
+static int cmp_manifest_path(const void* a, const void* b) {
+    return strcmp(((const ManifestEntry*)a)->path, ((const ManifestEntry*)b)->path);
+}
+
+static ManifestEntry* find_prev(const char* path) {
+    if (prev_count == 0) return NULL;
+    ManifestEntry key = { .path = (char*)path };
+    return bsearch(&key, prev_ents, prev_count, sizeof(ManifestEntry), cmp_manifest_path);
+}
+
+// 이전 매니페스트에서 경로, 크기, 해시가 같으면 이전 아카이브 범위를 연결
+static int match_prev(FileEntry* f) {
+    ManifestEntry* e = find_prev(f->path);
+    if (!e || e->size != f->size || e->hash != f->hash || e->end < e->off) return 0;
+    f->prev_off = e->off;
+    f->prev_end = e->end;
+    f->nblocks = e->nblocks;
+    return 1;
+}
+
+// 리더가 지금 읽어 갈 수 있는 작업 수 (아카이브 모드는 계획이 늘어나는 중일 수 있음)
+static long readable_blocks() {
+    return archiving ? planned_blocks : total_blocks;
+}
+
+// 슬롯이 비었을 때 하나만 깨움: 읽을 작업이 있으면 리더, 없으면 탐색 스레드 (pool_mutex 를 잡고 호출)
+static void wake_slot_waiter() {
+    if (archiving && next_read >= readable_blocks()) pthread_cond_signal(&discover_slot);
+    else pthread_cond_signal(&slot_free);
+}
+
+// 해시가 끝난 파일을 발견 순서대로 계획에 붙임 (pool_mutex 를 잡고 호출)
+// 변경 없는 파일은 복사 1건, 나머지는 블록 단위
+static void plan_ready_files() {
+    while (next_plan < file_count && file_at(next_plan)->hashed) {
+        FileEntry* f = file_at(next_plan);
+        long first = planned_blocks;
+        if (match_prev(f)) {
+            BlockPlan* pl = chunk_slot((void**)plan_chunks, planned_blocks++, PLAN_CHUNK, sizeof(BlockPlan));
+            pl->file = next_plan;
+            pl->copy = 1;
+            unchanged_files++;
+        } else {
+            for (long long off = 0; off < f->size; off += block_size) {
+                BlockPlan* pl = chunk_slot((void**)plan_chunks, planned_blocks++, PLAN_CHUNK, sizeof(BlockPlan));
+                pl->file = next_plan;
+                pl->src_off = off;
+                pl->len = f->size - off < block_size ? (int)(f->size - off) : block_size;
+            }
+            f->nblocks = planned_blocks - first;
+        }
+        if (planned_blocks > first) {
+            plan_at(first)->first = 1;
+            plan_at(planned_blocks - 1)->last = 1;
+        }
+        next_plan++;
+    }
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_u64(uint8_t* p, uint64_t v) {
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get_u64(const uint8_t* p) {
+    return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+// 버퍼를 끝까지 채우도록 반복해서 읽음 (파이프는 짧게 읽힐 수 있음)
+static size_t read_full(FILE* in, uint8_t* buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        size_t r = fread(buf + got, 1, len - got, in);
+        if (r == 0) break;
+        got += r;
+    }
+    return got;
+}
+
+static int write_full(FILE* out, const uint8_t* buf, size_t len) {
+    if (fwrite(buf, 1, len, out) != len) {
+        perror("write failed");
+        return -1;
+    }
+    bytes_out += len;
+    return 0;
+}
+
+static void run_help_items(HelpJob* job) {
+    int i;
+    while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->items)
+        job->fn(job->ctx, i);
+}
+
+// par_runner: 항목을 유휴 워커와 나눠 실행하고 모두 끝날 때까지 기다림
+// 이미 다른 블록이 도움을 받는 중이면 혼자 실행
+void help_par_for(par_fn fn, void* ctx, int items) {
+    HelpJob job = { fn, ctx, items, 0, 0 };
+    int shared = 0;
+    pthread_mutex_lock(&queue_mutex);
+    if (help_job == NULL && items > 1) {
+        help_job = &job;
+        shared = 1;
+        pthread_cond_broadcast(&queue_not_empty);
+    }
+    pthread_mutex_unlock(&queue_mutex);
+
+    run_help_items(&job);
+    if (!shared) return;
+    pthread_mutex_lock(&queue_mutex);
+    help_job = NULL;
+    while (job.helpers > 0)
+        pthread_cond_wait(&helpers_left, &queue_mutex);
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+// 이 워커의 작업 메모리를 최소 len 바이트로 (부족할 때만 다시 매핑)
+static void* worker_work(size_t len) {
+    void* ws = hugebuf_reserve(&worker_ws, len, work_mode == WORK_HUGETLB);
+    if (ws) __atomic_store_n(&work_kind, worker_ws.kind, __ATOMIC_RELAXED);
+    return ws;
+}
+
+// BWT 단계 (큰 블록이고 놀고 있는 워커가 있으면 접미사 정렬을 병렬로)
+void apply_bwt(Block* b) {
+    int par = b->len >= PAR_BWT_MIN && __atomic_load_n(&idle_workers, __ATOMIC_RELAXED) > 0;
+    int rc;
+    b->streams = bwt_stream_count(b->len);
+    if (work_mode == WORK_MALLOC) {
+        rc = par ? bwt_encode_parallel(b->data, b->work, b->len, &b->primary, b->anchors, b->streams, help_par_for)
+            : bwt_encode(b->data, b->work, b->len, &b->primary, b->anchors, b->streams);
+    } else {
+        void* ws = worker_work(par ? PAR_BWT_WORK_BYTES(b->len) : BWT_WORK_BYTES(b->len));
+        rc = ws == NULL ? -1
+            : par ? bwt_encode_parallel_ws(b->data, b->work, b->len, &b->primary, b->anchors, b->streams, help_par_for, ws)
+            : bwt_encode_ws(b->data, b->work, b->len, &b->primary, b->anchors, b->streams, ws);
+    }
+    if (rc < 0) {
+        fprintf(stderr, "Out of memory in BWT (block %ld).\n", b->seq);
+        exit(1);
+    }
+    uint8_t* t = b->data; b->data = b->work; b->work = t;
+}
+
+// MTF 단계 (제자리)
+void apply_mtf(Block* b) {
+    mtf_encode(b->data, b->len);
+}
+
+// 역변환 앵커를 페이로드 뒤에 붙임 (줄기가 하나면 없음)
+static int anchor_bytes(const Block* b) {
+    return b->streams > 1 ? 4 * (b->streams - 1) + 1 : 0;
+}
+
+static void append_anchors(Block* b) {
+    if (b->streams <= 1) return;
+    uint8_t* p = b->data + b->out_len;
+    for (int k = 0; k < b->streams - 1; k++)
+        put_u32(p + 4 * k, b->anchors[k]);
+    p[4 * (b->streams - 1)] = (uint8_t)b->streams;
+    b->out_len += anchor_bytes(b);
+}
+
+// 해제: 앵커가 붙은 블록이면 페이로드 끝에서 떼어 내고 기본 방식을 돌려줌 (잘못되면 -1)
+static int take_anchors(Block* b) {
+    b->streams = 1;
+    if (b->method != METHOD_BWT_MS && b->method != METHOD_BWT_HUF_MS) return b->method;
+    if (b->out_len < 1) return -1;
+    int k = b->data[b->out_len - 1];
+    if (k < 2 || k > BWT_MAX_STREAMS || b->out_len < 4 * (k - 1) + 1) return -1;
+    b->streams = k;
+    b->out_len -= anchor_bytes(b);
+    for (int i = 0; i < k - 1; i++)
+        b->anchors[i] = (int)get_u32(b->data + b->out_len + 4 * i);
+    return b->method == METHOD_BWT_MS ? METHOD_BWT : METHOD_BWT_HUF;
+}
+
+// RLE 출력을 받을 스레드별 버퍼 (BWT 뒤에도 work 에는 원본이 남아 있어서 stored 로 돌아갈 때 그대로 씀)
+static uint8_t* rle_scratch(Block* b) {
+    uint8_t* p = hugebuf_reserve(&worker_rle, RLE_BOUND((size_t)b->len), 0);
+    if (!p) {
+        fprintf(stderr, "Out of memory for the RLE buffer (block %ld).\n", b->seq);
+        exit(1);
+    }
+    return p;
+}
+
+// RLE 결과 (rle 에 n 바이트) 와 Huffman 계획으로 세 방식 중 가장 작은 것을 기록
+// (Huffman 은 크기를 먼저 계산해서 이득이 있을 때만 실제로 부호화, 앵커 크기도 포함해서 비교)
+// data 의 BWT/MTF 결과는 더 필요 없으므로 출력 자리로 쓰고, stored 면 work 의 원본을 그대로 기록
+static void choose_method(Block* b, const uint8_t* rle, int n, HufJob* huf, size_t hsize) {
+    if (hsize == (size_t)-1) {
+        fprintf(stderr, "Out of memory in Huffman (block %ld).\n", b->seq);
+        exit(1);
+    }
+    size_t extra = anchor_bytes(b);
+    if (hsize < (size_t)n && hsize + extra < (size_t)b->len) {
+        huf_encode(huf, b->data, help_par_for);
+        huf_free(huf);
+        b->method = extra ? METHOD_BWT_HUF_MS : METHOD_BWT_HUF;
+        b->out_len = hsize;
+        append_anchors(b);
+        return;
+    }
+    huf_free(huf);
+    if (n + extra < (size_t)b->len) {
+        memcpy(b->data, rle, n);
+        b->method = extra ? METHOD_BWT_MS : METHOD_BWT;
+        b->out_len = n;
+        append_anchors(b);
+        return;
+    }
+    uint8_t* t = b->data; b->data = b->work; b->work = t;
+    b->method = METHOD_STORED;
+    b->out_len = b->len;
+}
+
+// RLE + Huffman 단계 (MTF 단계의 결과를 읽음)
+void apply_rle(Block* b) {
+    uint8_t* rle = rle_scratch(b);
+    int n = rle_encode(b->data, b->len, rle);
+    HufJob huf;
+    size_t hsize = huf_plan(&huf, rle, n, help_par_for);
+    choose_method(b, rle, n, &huf, hsize);
+}
+
+// MTF + RLE + Huffman 을 한 단계로 (-F): BWT 출력에서 바로 RLE 스트림과 청크별 빈도를 만들고
+// Huffman 은 히스토그램 단계 없이 코드 계산으로 넘어감. 결과는 두 단계로 나눈 것과 같음
+void apply_mtf_rle(Block* b) {
+    HufJob huf;
+    if (huf_alloc(&huf, RLE_BOUND(b->len)) < 0) {
+        fprintf(stderr, "Out of memory in Huffman (block %ld).\n", b->seq);
+        exit(1);
+    }
+    uint8_t* rle = rle_scratch(b);
+    int n = mtf_rle_encode(b->data, b->len, rle, huf.freq);
+    size_t hsize = huf_plan_counted(&huf, rle, n);
+    choose_method(b, rle, n, &huf, hsize);
+}
+
+// RAW 블록 판별: 압축이 안 될 블록은 stored 로 바로 끝내고 (반환 1),
+// -L 이면 중간 정도의 블록은 LZ 로 끝냄. 나머지는 BWT 로 (반환 0)
+int probe_raw_block(Block* b) {
+    Probe p = probe_block(b->data, b->len);
+    if (p.bits >= PROBE_STORED_BITS && p.match < PROBE_STORED_MATCH) {
+        b->method = METHOD_STORED;
+        b->out_len = b->len;
+        __atomic_fetch_add(&probe_stored, 1, __ATOMIC_RELAXED);
+        return 1;
+    }
+    if (!fast_lz || p.bits < PROBE_LZ_BITS) return 0;
+    int n = lz_encode(b->data, b->len, b->work, b->len);
+    if (n < 0) {
+        b->method = METHOD_STORED;
+        b->out_len = b->len;
+    } else {
+        uint8_t* t = b->data; b->data = b->work; b->work = t;
+        b->method = METHOD_LZ;
+        b->out_len = n;
+    }
+    __atomic_fetch_add(&probe_lz, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+// 작업 큐에 추가 (단계별 큐 사용)
+void enqueue_block(Block* b) {
+    pthread_mutex_lock(&queue_mutex);
+    switch (b->stage) {
+    case RAW:
+    case DECODE:
+        raw_queue[raw_tail++ % max_inflight] = b;
+        break;
+    case BWT_DONE:
+        bwt_queue[bwt_tail++ % max_inflight] = b;
+        break;
+    case MTF_DONE:
+        mtf_queue[mtf_tail++ % max_inflight] = b;
+        break;
+    case HASH:
+        hash_queue[hash_tail++ % max_inflight] = b;
+        break;
+    default:
+        break;
+    }
+    pthread_cond_signal(&queue_not_empty);
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+// 우선순위가 가장 높은 블록을 꺼냄 (종료 시 NULL)
+Block* dequeue_highest_priority_block() {
+    pthread_mutex_lock(&queue_mutex);
+    while (raw_head == raw_tail && bwt_head == bwt_tail && mtf_head == mtf_tail &&
+           hash_head == hash_tail && !shutting_down) {
+        // 할 일이 없으면 큰 블록의 BWT 를 거듦
+        HelpJob* job = help_job;
+        if (job && __atomic_load_n(&job->next, __ATOMIC_RELAXED) < job->items) {
+            job->helpers++;
+            pthread_mutex_unlock(&queue_mutex);
+            run_help_items(job);
+            pthread_mutex_lock(&queue_mutex);
+            if (--job->helpers == 0) pthread_cond_signal(&helpers_left);
+            continue;
+        }
+        idle_workers++;
+        pthread_cond_wait(&queue_not_empty, &queue_mutex);
+        idle_workers--;
+    }
+    Block* b = NULL;
+    if (mtf_head < mtf_tail) {
+        b = mtf_queue[mtf_head++ % max_inflight];
+    } else if (bwt_head < bwt_tail) {
+        b = bwt_queue[bwt_head++ % max_inflight];
+    } else if (raw_head < raw_tail) {
+        b = raw_queue[raw_head++ % max_inflight];
+    } else if (hash_head < hash_tail) {
+        b = hash_queue[hash_head++ % max_inflight];
+    }
+    pthread_mutex_unlock(&queue_mutex);
+    return b;
+}
+
+// 완료된 블록을 재정렬 버퍼에 넣고 writer 를 깨움
+void finish_block(Block* b) {
+    pthread_mutex_lock(&pool_mutex);
+    reorder[b->seq % max_inflight] = b;
+    if (b->seq == next_write) pthread_cond_signal(&block_done);
+    pthread_mutex_unlock(&pool_mutex);
+    if (event_fd >= 0) {
+        uint64_t one = 1;
+        if (write(event_fd, &one, sizeof(one)) < 0) perror("eventfd write failed");
+    }
+}
+
+// 해시 작업: 슬롯 버퍼로 파일을 끝까지 읽으며 XXH64 계산
+void hash_file(Block* b) {
+    FileEntry* f = file_at(b->file);
+    int fd = open(f->path, O_RDONLY);
+    if (fd < 0) {
+        perror(f->path);
+        exit(1);
+    }
+    Xxh64 st;
+    xxh64_init(&st, 0);
+    long long off = 0;
+    while (1) {
+        ssize_t r = pread(fd, b->data, buf_cap, off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) {
+            perror(f->path);
+            exit(1);
+        }
+        if (r == 0) break;
+        xxh64_update(&st, b->data, r);
+        off += r;
+    }
+    close(fd);
+    f->hash = xxh64_digest(&st);
+
+    pthread_mutex_lock(&pool_mutex);
+    free_slots[free_count++] = b;
+    hashes_done++;
+    f->hashed = 1;
+    plan_ready_files();
+    wake_slot_waiter();
+    pthread_cond_signal(&hash_done);
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+// DECODE 단계: 블록 하나를 복원하고 원본 체크섬을 확인 (결과는 data, 실패하면 METHOD_CORRUPT)
+void decode_block(Block* b) {
+    int len = b->len, ok = 0;
+    uint8_t* t;
+    switch (take_anchors(b)) {
+    case METHOD_STORED:
+        ok = b->out_len == len;
+        break;
+    case METHOD_LZ:
+        ok = lz_decode(b->data, b->out_len, b->work, len) == len;
+        t = b->data; b->data = b->work; b->work = t;
+        break;
+    case METHOD_BWT:
+        ok = rle_decode(b->data, b->out_len, b->work, len) == len;
+        if (ok) {
+            mtf_decode(b->work, len);
+            ok = bwt_decode_streams(b->work, b->data, len, b->primary, b->anchors, b->streams) == 0;
+        }
+        break;
+    case METHOD_BWT_HUF: {
+        // Huffman 을 풀어서 work 에 RLE 스트림, 그 뒤는 data 에서 BWT 까지
+        int rle_len = huf_decode(b->data, b->out_len, b->work, RLE_BOUND(len));
+        ok = rle_len >= 0 && rle_decode(b->work, rle_len, b->data, len) == len;
+        if (ok) {
+            mtf_decode(b->data, len);
+            ok = bwt_decode_streams(b->data, b->work, len, b->primary, b->anchors, b->streams) == 0;
+            t = b->data; b->data = b->work; b->work = t;
+        }
+        break;
+    }
+    }
+    if (!ok) {
+        fprintf(stderr, "Corrupt block data (block %ld).\n", b->seq);
+        b->method = METHOD_CORRUPT;
+        return;
+    }
+    if (stream_crc) {
+        if (crc32c(0, b->data, len) != b->crc) {
+            fprintf(stderr, "Checksum mismatch in block %ld.\n", b->seq);
+            b->method = METHOD_CORRUPT;
+            return;
+        }
+        __atomic_fetch_add(&crc_verified, 1, __ATOMIC_RELAXED);
+    }
+    b->out_len = len;
+}
+
+void* worker_thread(void* arg) {
+    Block* b;
+    // 첫 블록에서 page fault 가 몰리지 않게 시작할 때 미리 잡아 둠
+    if (work_mode != WORK_MALLOC && !decompressing) worker_work(BWT_WORK_BYTES(block_size));
+    while ((b = dequeue_highest_priority_block()) != NULL) {
+        switch (b->stage) {
+        case RAW:
+            // 방금 읽어서 캐시에 있을 때 원본 체크섬 계산
+            b->crc = crc32c(0, b->data, b->len);
+            if (probe_raw_block(b)) {
+                b->stage = DONE;
+                finish_block(b);
+                break;
+            }
+            apply_bwt(b);
+            b->stage = BWT_DONE;
+            enqueue_block(b);
+            break;
+        case BWT_DONE:
+            if (fused_mtf_rle) {
+                apply_mtf_rle(b);
+                b->stage = DONE;
+                finish_block(b);
+                break;
+            }
+            apply_mtf(b);
+            b->stage = MTF_DONE;
+            enqueue_block(b);
+            break;
+        case MTF_DONE:
+            apply_rle(b);
+            b->stage = DONE;
+            finish_block(b);
+            break;
+        case HASH:
+            hash_file(b);
+            break;
+        case DECODE:
+            decode_block(b);
+            b->stage = DONE;
+            finish_block(b);
+            break;
+        default:
+            break;
+        }
+    }
+    hugebuf_unmap(&worker_ws);
+    hugebuf_unmap(&worker_rle);
+    return NULL;
+}
+
+// 블록 헤더를 채우고 writev 용 iovec 준비
+static void prepare_block_record(Block* b) {
+    put_u32(b->hdr, b->len);
+    b->hdr[4] = (uint8_t)b->method;
+    put_u32(b->hdr + 5, b->primary);
+    put_u32(b->hdr + 9, b->out_len);
+    put_u32(b->hdr + 13, b->crc);
+    b->iov[0].iov_base = b->hdr;
+    b->iov[0].iov_len = sizeof(b->hdr);
+    b->iov[1].iov_base = b->data;
+    b->iov[1].iov_len = b->out_len;
+}
+
+// 출력 파일(-o)이 있으면 pwrite, 아니면 stdout 에 순서대로 기록
+static int emit_bytes(const uint8_t* buf, size_t len) {
+    if (fd_out < 0) return write_full(stdout, buf, len);
+    while (len > 0) {
+        ssize_t w = pwrite(fd_out, buf, len, out_off);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            perror("pwrite failed");
+            return -1;
+        }
+        buf += w;
+        len -= w;
+        out_off += w;
+        bytes_out += w;
+    }
+    return 0;
+}
+
+// 이전 아카이브의 [off, off+len) 을 출력 위치로 복사 (가능하면 커널 내 복사)
+static int copy_from_prev(long long off, long long len) {
+    loff_t src = off;
+    while (len > 0) {
+        ssize_t n = copy_file_range(prev_fd, &src, fd_out, &out_off, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        len -= n;
+        bytes_out += n;
+    }
+    uint8_t buf[65536];
+    while (len > 0) {
+        ssize_t r = pread(prev_fd, buf, len < (long long)sizeof(buf) ? len : (long long)sizeof(buf), src);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+            fprintf(stderr, "Previous archive is shorter than its manifest.\n");
+            return -1;
+        }
+        if (emit_bytes(buf, r) < 0) return -1;
+        src += r;
+        len -= r;
+    }
+    return 0;
+}
+
+// 블록 하나(또는 복사 작업)를 출력하고 파일별 아카이브 범위를 기록
+static int write_block(Block* b) {
+    BlockPlan* pl = archiving ? plan_at(b->seq) : NULL;
+    if (pl && pl->first) file_at(pl->file)->arc_off = out_off;
+    int rc;
+    if (decompressing) {
+        // 추출이면 첫 블록 안의 시작 위치부터 파일 크기만큼만
+        long long skip = extract_skip < b->out_len ? extract_skip : b->out_len;
+        long long n = b->out_len - skip;
+        if (extract_left >= 0 && n > extract_left) n = extract_left;
+        extract_skip -= skip;
+        if (extract_left >= 0) extract_left -= n;
+        rc = b->method == METHOD_CORRUPT ? -1 : emit_bytes(b->data + skip, n);
+    } else if (b->method == METHOD_COPY) {
+        FileEntry* f = file_at(pl->file);
+        rc = copy_from_prev(f->prev_off, f->prev_end - f->prev_off);
+    } else {
+        prepare_block_record(b);
+        rc = emit_bytes(b->hdr, sizeof(b->hdr)) < 0 || emit_bytes(b->data, b->out_len) < 0 ? -1 : 0;
+    }
+    if (pl && pl->last) file_at(pl->file)->arc_end = out_off;
+    return rc;
+}
+
+// writer 스레드: 입력 순서대로 블록을 기록하고 슬롯을 반납
+void* writer_thread(void* arg) {
+    int failed = 0;
+    while (1) {
+        pthread_mutex_lock(&pool_mutex);
+        Block* b;
+        while ((b = reorder[next_write % max_inflight]) == NULL || b->seq != next_write) {
+            if (total_blocks >= 0 && next_write >= total_blocks) {
+                pthread_mutex_unlock(&pool_mutex);
+                return (void*)(intptr_t)failed;
+            }
+            pthread_cond_wait(&block_done, &pool_mutex);
+        }
+        reorder[next_write % max_inflight] = NULL;
+        pthread_mutex_unlock(&pool_mutex);
+
+        if (!failed && write_block(b) < 0)
+            failed = 1;
+
+        pthread_mutex_lock(&pool_mutex);
+        next_write++;
+        free_slots[free_count++] = b;
+        wake_slot_waiter();
+        pthread_mutex_unlock(&pool_mutex);
+    }
+}
+
+// stdin 입력: 메인 스레드가 순차로 읽어서 큐에 흘려보냄
+int run_stdin_io() {
+    pthread_t writer;
+    pthread_create(&writer, NULL, writer_thread, NULL);
+
+    long seq = 0;
+    while (1) {
+        pthread_mutex_lock(&pool_mutex);
+        while (free_count == 0)
+            pthread_cond_wait(&slot_free, &pool_mutex);
+        Block* b = free_slots[--free_count];
+        pthread_mutex_unlock(&pool_mutex);
+
+        size_t n = read_full(stdin, b->data, block_size);
+        if (n == 0) {
+            pthread_mutex_lock(&pool_mutex);
+            free_slots[free_count++] = b;
+            total_blocks = seq;
+            pthread_cond_signal(&block_done);
+            pthread_mutex_unlock(&pool_mutex);
+            break;
+        }
+        bytes_in += n;
+        b->seq = seq++;
+        b->len = (int)n;
+        b->stage = RAW;
+        b->primary = 0;
+        enqueue_block(b);
+    }
+
+    void* ret;
+    pthread_join(writer, &ret);
+    if (ferror(stdin)) {
+        perror("read failed");
+        return -1;
+    }
+    return ret != NULL ? -1 : 0;
+}
+
+// 블록 seq 의 기대 길이 (마지막 블록만 짧음)
+static int expected_len(long seq) {
+    long long rest = input_size - (long long)seq * block_size;
+    return rest < block_size ? (int)rest : block_size;
+}
+
+// pread 리더 스레드: 빈 슬롯이 생기는 대로 다음 블록을 미리 읽음
+// (아카이브 모드는 같은 파일의 블록이 이어지므로 마지막에 연 파일을 재사용)
+void* reader_thread(void* arg) {
+    int cur_file = -1, cur_fd = -1;
+    while (1) {
+        pthread_mutex_lock(&pool_mutex);
+        while (free_count == 0 || next_read >= readable_blocks()) {
+            if (total_blocks >= 0 && next_read >= total_blocks) {
+                pthread_mutex_unlock(&pool_mutex);
+                if (cur_fd >= 0) close(cur_fd);
+                return NULL;
+            }
+            pthread_cond_wait(&slot_free, &pool_mutex);
+        }
+        long seq = next_read++;
+        Block* b = free_slots[--free_count];
+        if (archiving && seq == 0) gettimeofday(&first_block_time, NULL);
+        pthread_mutex_unlock(&pool_mutex);
+
+        b->seq = seq;
+        BlockPlan* pl = archiving ? plan_at(seq) : NULL;
+        if (pl && pl->copy) {
+            // 변경 없는 파일: 압축 단계를 건너뛰고 writer 가 이전 아카이브에서 복사
+            b->method = METHOD_COPY;
+            b->stage = DONE;
+            finish_block(b);
+            continue;
+        }
+        int fd = fd_in;
+        if (pl && pl->file != cur_file) {
+            if (cur_fd >= 0) close(cur_fd);
+            const char* path = file_at(pl->file)->path;
+            if ((cur_fd = open(path, O_RDONLY)) < 0) {
+                perror(path);
+                exit(1);
+            }
+            cur_file = pl->file;
+        }
+        if (pl) fd = cur_fd;
+        off_t base = pl ? pl->src_off : (off_t)seq * block_size;
+        int want = pl ? pl->len : expected_len(seq);
+        int got = 0;
+        while (got < want) {
+            // O_DIRECT 는 정렬된 길이가 필요하므로 항상 블록 전체를 요청
+            ssize_t r = pread(fd, b->data + got, block_size - got, base + got);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) {
+                perror("pread failed");
+                exit(1);
+            }
+            if (r == 0) {
+                fprintf(stderr, "unexpected end of input at block %ld\n", seq);
+                exit(1);
+            }
+            got += r;
+        }
+        __atomic_fetch_add(&bytes_in, want, __ATOMIC_RELAXED);
+        b->len = want;
+        b->stage = RAW;
+        b->primary = 0;
+        enqueue_block(b);
+    }
+}
+
+// io_uring 미지원 시 대체 경로: pread 스레드 풀 + pwrite writer
+int run_pread_io() {
+    pthread_t readers[IO_READERS], writer;
+    for (int i = 0; i < IO_READERS; i++)
+        pthread_create(&readers[i], NULL, reader_thread, NULL);
+    pthread_create(&writer, NULL, writer_thread, NULL);
+
+    void* ret;
+    pthread_join(writer, &ret);
+    pthread_mutex_lock(&pool_mutex);
+    pthread_cond_broadcast(&slot_free);
+    pthread_mutex_unlock(&pool_mutex);
+    for (int i = 0; i < IO_READERS; i++)
+        pthread_join(readers[i], NULL);
+    return ret != NULL ? -1 : 0;
+}
+
+// io_uring 완료 이벤트 종류 (user_data 하위 비트)
+enum { IO_TAG_EVENT = 0, IO_TAG_READ = 1, IO_TAG_WRITE = 2 };
+
+// 블록의 아직 못 읽은 부분 (b->len 이후) 읽기 요청, SQ 가 가득 차면 -1
+static int uring_queue_read(Uring* ring, Block* b, int fixed) {
+    struct io_uring_sqe* sqe = uring_get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->fd = fd_in;
+    sqe->addr = (uintptr_t)(b->data + b->len);
+    sqe->len = block_size - b->len;
+    sqe->off = (uint64_t)b->seq * block_size + b->len;
+    if (fixed) {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->buf_index = 2 * (b - slots) + (b->data == b->bufs[1]);
+    } else {
+        sqe->opcode = IORING_OP_READ;
+    }
+    sqe->user_data = (uintptr_t)b | IO_TAG_READ;
+    return 0;
+}
+
+// io_uring 전용 I/O 스레드: 빈 슬롯만큼 읽기를 미리 한꺼번에 걸고,
+// 순서가 맞은 압축 블록들을 writev 로 묶어서 기록한다.
+// 워커의 완료 통지는 eventfd 읽기를 같은 링에 걸어 함께 기다린다.
+// 짧게 읽힌 블록은 나머지 구간으로 다시 걸고, 실패하면 걸려 있는 요청이 모두 끝난 뒤 돌아간다.
+int run_uring_io(Uring* ring) {
+    int err = 0;
+    int reads_inflight = 0, writes_inflight = 0, event_armed = 0;
+    uint64_t event_buf;
+    Block* short_reads[max_inflight];  // 나머지를 다시 읽어야 하는 블록
+    int short_count = 0;
+
+    struct iovec iov[2 * max_inflight];
+    for (int i = 0; i < max_inflight; i++) {
+        iov[2 * i].iov_base = slots[i].bufs[0];
+        iov[2 * i].iov_len = buf_cap;
+        iov[2 * i + 1].iov_base = slots[i].bufs[1];
+        iov[2 * i + 1].iov_len = buf_cap;
+    }
+    int fixed = uring_register_buffers(ring, iov, 2 * max_inflight) == 0;
+
+    while (next_write < total_blocks || writes_inflight > 0) {
+        // 1) 짧게 읽힌 블록의 나머지, 그다음 빈 슬롯 수만큼 읽기 요청 (수요보다 앞서서)
+        while (short_count > 0 && uring_queue_read(ring, short_reads[short_count - 1], fixed) == 0) {
+            short_count--;
+            reads_inflight++;
+        }
+        while (next_read < total_blocks && free_count > 0) {
+            Block* b = free_slots[free_count - 1];
+            b->seq = next_read;
+            b->len = 0;
+            if (uring_queue_read(ring, b, fixed) < 0) break;
+            free_count--;
+            next_read++;
+            reads_inflight++;
+        }
+
+        // 2) 순서가 맞은 완료 블록을 모아서 쓰기 요청
+        pthread_mutex_lock(&pool_mutex);
+        Block* b;
+        while ((b = reorder[next_write % max_inflight]) != NULL && b->seq == next_write) {
+            struct io_uring_sqe* sqe = uring_get_sqe(ring);
+            if (!sqe) break;
+            reorder[next_write % max_inflight] = NULL;
+            next_write++;
+            prepare_block_record(b);
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->fd = fd_out;
+            sqe->addr = (uintptr_t)b->iov;
+            sqe->len = 2;
+            sqe->off = out_off;
+            sqe->user_data = (uintptr_t)b | IO_TAG_WRITE;
+            out_off += sizeof(b->hdr) + b->out_len;
+            writes_inflight++;
+        }
+        pthread_mutex_unlock(&pool_mutex);
+
+        // 3) 워커 완료 통지용 eventfd 읽기
+        if (!event_armed) {
+            struct io_uring_sqe* sqe = uring_get_sqe(ring);
+            if (sqe) {
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = event_fd;
+                sqe->addr = (uintptr_t)&event_buf;
+                sqe->len = sizeof(event_buf);
+                sqe->off = 0;
+                sqe->user_data = IO_TAG_EVENT;
+                event_armed = 1;
+            }
+        }
+
+        int ret = uring_submit_and_wait(ring, 1);
+        if (ret < 0) {
+            fprintf(stderr, "io_uring_enter failed: %s\n", strerror(-ret));
+            err = -1;
+            break;
+        }
+
+        // 실패를 만나도 나머지 완료는 계속 거둬서 걸려 있는 요청 수를 맞춤
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek_cqe(ring)) != NULL) {
+            int tag = cqe->user_data & 3;
+            Block* cb = (Block*)(uintptr_t)(cqe->user_data & ~(uint64_t)3);
+            int res = cqe->res;
+            uring_cqe_seen(ring);
+
+            if (tag == IO_TAG_EVENT) {
+                event_armed = 0;
+            } else if (tag == IO_TAG_READ) {
+                reads_inflight--;
+                if (err < 0) continue;
+                int want = expected_len(cb->seq);
+                if (res <= 0) {
+                    if (res == 0)
+                        fprintf(stderr, "unexpected end of input at block %ld\n", cb->seq);
+                    else
+                        fprintf(stderr, "read of block %ld failed: %s\n", cb->seq, strerror(-res));
+                    err = -1;
+                    continue;
+                }
+                cb->len += res;
+                if (cb->len < want) {
+                    short_reads[short_count++] = cb;  // 나머지는 다음 바퀴에 offset + res 부터
+                    continue;
+                }
+                bytes_in += want;
+                cb->len = want;
+                cb->stage = RAW;
+                cb->primary = 0;
+                enqueue_block(cb);
+            } else {
+                writes_inflight--;
+                if (err < 0) continue;
+                if (res != (int)(sizeof(cb->hdr) + cb->out_len)) {
+                    fprintf(stderr, "write of block %ld failed: %s\n", cb->seq,
+                            res < 0 ? strerror(-res) : "short write");
+                    err = -1;
+                    continue;
+                }
+                bytes_out += res;
+                free_slots[free_count++] = cb;
+            }
+        }
+        if (err < 0) break;
+    }
+
+    // 실패로 빠져나가면 커널이 아직 슬롯 버퍼와 event_buf 를 쓰고 있을 수 있으므로
+    // 걸려 있는 읽기/쓰기가 모두 끝날 때까지 기다림 (eventfd 읽기는 직접 깨워서 끝냄)
+    if (event_armed) {
+        uint64_t one = 1;
+        if (write(event_fd, &one, sizeof(one)) < 0) perror("eventfd write failed");
+    }
+    while (reads_inflight + writes_inflight + event_armed > 0) {
+        int ret = uring_submit_and_wait(ring, 1);
+        if (ret < 0) {
+            fprintf(stderr, "io_uring_enter failed: %s\n", strerror(-ret));
+            break;
+        }
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek_cqe(ring)) != NULL) {
+            int tag = cqe->user_data & 3;
+            uring_cqe_seen(ring);
+            if (tag == IO_TAG_EVENT) event_armed = 0;
+            else if (tag == IO_TAG_READ) reads_inflight--;
+            else writes_inflight--;
+        }
+    }
+    return err;
+}
+
+// 파일 입력(-i/-o): io_uring I/O 스레드, 안 되면 pread 풀로 대체
+int run_file_io() {
+    struct stat st;
+    if (fstat(fd_in, &st) < 0) {
+        perror("fstat failed");
+        return -1;
+    }
+    input_size = st.st_size;
+    total_blocks = (input_size + block_size - 1) / block_size;
+
+    if (!force_pread) {
+        Uring ring;
+        int ret = uring_init(&ring, 2 * max_inflight + 2);
+        if (ret == 0) {
+            event_fd = eventfd(0, EFD_CLOEXEC);
+            if (event_fd >= 0) {
+                int rc = run_uring_io(&ring);
+                uring_exit(&ring);
+                close(event_fd);
+                event_fd = -1;
+                return rc;
+            }
+            uring_exit(&ring);
+        }
+        fprintf(stderr, "io_uring unavailable (%s), using pread pool.\n", strerror(ret < 0 ? -ret : errno));
+    }
+    return run_pread_io();
+}
+
+// 블록 슬롯 풀과 단계별 큐를 준비
+int setup_pool(int thread_count) {
+    max_inflight = thread_count * INFLIGHT_PER_THREAD + 2;
+    // O_DIRECT 를 위해 페이지 정렬
+    buf_cap = (RLE_BOUND((size_t)block_size) + 4095) & ~(size_t)4095;
+
+    slots = calloc(max_inflight, sizeof(Block));
+    free_slots = malloc(sizeof(Block*) * max_inflight);
+    reorder = calloc(max_inflight, sizeof(Block*));
+    raw_queue = malloc(sizeof(Block*) * max_inflight);
+    bwt_queue = malloc(sizeof(Block*) * max_inflight);
+    mtf_queue = malloc(sizeof(Block*) * max_inflight);
+    hash_queue = malloc(sizeof(Block*) * max_inflight);
+    for (int i = 0; i < max_inflight; i++) {
+        if (posix_memalign((void**)&slots[i].bufs[0], 4096, buf_cap) != 0 ||
+            posix_memalign((void**)&slots[i].bufs[1], 4096, buf_cap) != 0) {
+            fprintf(stderr, "Out of memory for %d blocks of %d bytes.\n", max_inflight, block_size);
+            return -1;
+        }
+        slots[i].data = slots[i].bufs[0];
+        slots[i].work = slots[i].bufs[1];
+        slots[i].cap = buf_cap;
+        free_slots[free_count++] = &slots[i];
+    }
+    return 0;
+}
+
+void free_pool() {
+    for (int i = 0; i < max_inflight; i++) {
+        free(slots[i].bufs[0]);
+        free(slots[i].bufs[1]);
+    }
+    free(slots); free(free_slots); free(reorder);
+    free(raw_queue); free(bwt_queue); free(mtf_queue); free(hash_queue);
+}
+
+void start_workers(pthread_t* threads, int thread_count) {
+    for (int i = 0; i < thread_count; i++)
+        pthread_create(&threads[i], NULL, worker_thread, NULL);
+}
+
+void stop_workers(pthread_t* threads, int thread_count) {
+    pthread_mutex_lock(&queue_mutex);
+    shutting_down = 1;
+    pthread_cond_broadcast(&queue_not_empty);
+    pthread_mutex_unlock(&queue_mutex);
+    for (int i = 0; i < thread_count; i++)
+        pthread_join(threads[i], NULL);
+}
+
+// 스트림 끝 표시 (원본 길이 0)
+static int emit_end_marker() {
+    uint8_t end[4];
+    put_u32(end, 0);
+    if (emit_bytes(end, 4) < 0 || fflush(stdout) != 0) return -1;
+    return 0;
+}
+
+// 압축 실행 함수: 블록 슬롯을 준비하고 입력 종류에 맞는 I/O 경로로 실행
+int run_stream_compressor(int thread_count) {
+    if (setup_pool(thread_count) < 0) return 1;
+    if (emit_bytes((const uint8_t*)STREAM_MAGIC, 4) < 0) return 1;
+
+    pthread_t threads[thread_count];
+    start_workers(threads, thread_count);
+    int ret = fd_in >= 0 ? run_file_io() : run_stdin_io();
+    if (ret < 0) return 1;
+    stop_workers(threads, thread_count);
+
+    if (emit_end_marker() < 0) return 1;
+    free_pool();
+    return 0;
+}
+
+// ── 아카이브 모드: 매니페스트 기반 증분 압축 ──
+
+// 이전 매니페스트를 읽어 둠 (해시가 끝나는 파일마다 match_prev 로 비교)
+void load_prev_manifest(const char* archive, const char* manifest) {
+    FILE* mf = fopen(manifest, "r");
+    if (!mf) return;
+    prev_fd = open(archive, O_RDONLY);
+    char magic[4];
+    if (prev_fd < 0 || pread(prev_fd, magic, 4, 0) != 4 || memcmp(magic, STREAM_MAGIC, 4) != 0) {
+        fprintf(stderr, "Ignoring %s: previous archive missing or invalid.\n", manifest);
+        if (prev_fd >= 0) close(prev_fd);
+        prev_fd = -1;
+        fclose(mf);
+        return;
+    }
+
+    int cap = 0;
+    char line[8192];
+    while (fgets(line, sizeof(line), mf)) {
+        if (line[0] == '#') continue;
+        line[strcspn(line, "\n")] = '\0';
+        ManifestEntry e;
+        unsigned long long h;
+        int pos = 0;
+        if (sscanf(line, "%llx %lld %lld %lld %lld %ld %n", &h, &e.size, &e.mtime, &e.off, &e.end, &e.nblocks, &pos) < 6 ||
+            pos == 0 || line[pos] == '\0')
+            continue;
+        e.hash = h;
+        e.path = strdup(line + pos);
+        if (prev_count == cap) {
+            int grown_cap = cap ? cap * 2 : 64;
+            ManifestEntry* grown = realloc(prev_ents, sizeof(ManifestEntry) * grown_cap);
+            if (!grown) {
+                fprintf(stderr, "Failed to grow the manifest table, ignoring the rest of %s.\n", manifest);
+                free(e.path);
+                break;
+            }
+            prev_ents = grown;
+            cap = grown_cap;
+        }
+        prev_ents[prev_count++] = e;
+    }
+    fclose(mf);
+    if (prev_count > 0) qsort(prev_ents, prev_count, sizeof(ManifestEntry), cmp_manifest_path);
+}
+
+int write_manifest(const char* path) {
+    FILE* mf = fopen(path, "w");
+    if (!mf) {
+        perror(path);
+        return -1;
+    }
+    fprintf(mf, "%s\n# xxh64 size mtime_ns archive_off archive_end blocks path\n", MANIFEST_HEADER);
+    for (int i = 0; i < file_count; i++) {
+        FileEntry* f = file_at(i);
+        fprintf(mf, "%016llx %lld %lld %lld %lld %ld %s\n", (unsigned long long)f->hash, f->size, f->mtime,
+                f->arc_off, f->arc_end, f->nblocks, f->path);
+    }
+    if (fflush(mf) != 0 || fsync(fileno(mf)) < 0) {
+        perror(path);
+        fclose(mf);
+        return -1;
+    }
+    return fclose(mf);
+}
+
+static int cmp_file_path(const void* a, const void* b) {
+    return strcmp(file_at(*(const int*)a)->path, file_at(*(const int*)b)->path);
+}
+
+// 끝 표시 뒤에 파일 색인을 붙임: 이름순 고정 크기 항목 + 이름 표 + 꼬리 (색인 위치, CRC32C, 매직)
+// 블록은 파일마다 새로 시작하므로 첫 블록 안 위치는 항상 0 (형식에는 남겨 둠)
+// 끝 표시 앞까지는 기존 스트림과 같아서 -d 는 색인을 읽지 않고 그대로 해제
+int write_archive_index() {
+    uint64_t index_off = out_off;
+    int* order = malloc(sizeof(int) * (file_count > 0 ? file_count : 1));
+    long* first = malloc(sizeof(long) * (file_count > 0 ? file_count : 1));
+    if (!order || !first) {
+        fprintf(stderr, "Out of memory for the archive index.\n");
+        return -1;
+    }
+    size_t names_len = 0;
+    long blocks = 0;
+    for (int i = 0; i < file_count; i++) {
+        order[i] = i;
+        first[i] = blocks;
+        blocks += file_at(i)->nblocks;
+        names_len += strlen(file_at(i)->path) + 1;
+    }
+    qsort(order, file_count, sizeof(int), cmp_file_path);
+
+    size_t len = INDEX_HEADER + (size_t)file_count * INDEX_ENTRY + names_len;
+    uint8_t* buf = malloc(len + INDEX_TRAILER);
+    if (!buf) {
+        fprintf(stderr, "Out of memory for the archive index.\n");
+        return -1;
+    }
+    memcpy(buf, INDEX_MAGIC, 4);
+    put_u32(buf + 4, file_count);
+    uint8_t* names = buf + INDEX_HEADER + (size_t)file_count * INDEX_ENTRY;
+    size_t name_off = 0;
+    for (int k = 0; k < file_count; k++) {
+        FileEntry* f = file_at(order[k]);
+        uint8_t* e = buf + INDEX_HEADER + (size_t)k * INDEX_ENTRY;
+        put_u64(e, f->nblocks > 0 ? f->arc_off : 0);
+        put_u64(e + 8, f->nblocks > 0 ? f->arc_end : 0);
+        put_u64(e + 16, f->size);
+        put_u32(e + 24, first[order[k]]);
+        put_u32(e + 28, f->nblocks);
+        put_u32(e + 32, 0);
+        put_u32(e + 36, name_off);
+        size_t n = strlen(f->path) + 1;
+        memcpy(names + name_off, f->path, n);
+        name_off += n;
+    }
+    put_u64(buf + len, index_off);
+    put_u32(buf + len + 8, crc32c(0, buf, len));
+    memcpy(buf + len + 12, INDEX_TAIL_MAGIC, 4);
+    int rc = emit_bytes(buf, len + INDEX_TRAILER);
+    free(buf);
+    free(order);
+    free(first);
+    return rc;
+}
+
+// 발견한 파일을 표에 붙이고 곧바로 해시 작업으로 큐에 넣음 (탐색 스레드와 메인 스레드에서 호출)
+void add_archive_file(void* ctx, char* path, const struct stat* st) {
+    pthread_mutex_lock(&pool_mutex);
+    int i = file_count;
+    FileEntry* f = chunk_slot((void**)file_chunks, i, FILE_CHUNK, sizeof(FileEntry));
+    f->path = path;
+    f->size = st->st_size;
+    f->mtime = st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+    f->prev_off = f->prev_end = -1;
+    file_count++;
+    // 크기와 수정 시각이 이전 매니페스트와 같으면 읽지 않고 이전 해시를 그대로 씀
+    // (시각이 다르면 해시 작업으로 보내서 내용이 정말 같은지 확인)
+    ManifestEntry* e = find_prev(path);
+    if (e && e->size == f->size && e->mtime == f->mtime) {
+        f->hash = e->hash;
+        f->hashed = 1;
+        hashes_done++;
+        rehash_skipped++;
+        plan_ready_files();
+        wake_slot_waiter();
+        pthread_cond_signal(&hash_done);
+        pthread_mutex_unlock(&pool_mutex);
+        return;
+    }
+    while (free_count == 0)
+        pthread_cond_wait(&discover_slot, &pool_mutex);
+    Block* b = free_slots[--free_count];
+    pthread_mutex_unlock(&pool_mutex);
+    b->file = i;
+    b->stage = HASH;
+    enqueue_block(b);
+}
+
+static double elapsed_ms(const struct timeval* from, const struct timeval* to) {
+    return (to->tv_sec - from->tv_sec) * 1000.0 + (to->tv_usec - from->tv_usec) / 1000.0;
+}
+
+// 파일/디렉터리 목록을 아카이브로 압축하고 <archive>.manifest 를 남김
+// 탐색, 해시, 압축, 기록이 모두 겹쳐서 진행되고, 탐색이 끝나고 모든 해시가
+// 계획에 들어간 뒤에야 전체 블록 수가 정해짐 (stdin 입력의 EOF 와 같은 역할)
+int run_archive_compressor(int thread_count, const char* archive, char** paths, int n) {
+    char manifest[4096], tmp_archive[4096], tmp_manifest[4096];
+    snprintf(manifest, sizeof(manifest), "%s.manifest", archive);
+    snprintf(tmp_archive, sizeof(tmp_archive), "%s.tmp", archive);
+    snprintf(tmp_manifest, sizeof(tmp_manifest), "%s.manifest.tmp", archive);
+    archiving = 1;
+    load_prev_manifest(archive, manifest);
+
+    if (setup_pool(thread_count) < 0) return 1;
+    fd_out = open(tmp_archive, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_out < 0) {
+        perror(tmp_archive);
+        return 1;
+    }
+    if (emit_bytes((const uint8_t*)STREAM_MAGIC, 4) < 0) return 1;
+
+    pthread_t threads[thread_count], readers[IO_READERS], writer;
+    start_workers(threads, thread_count);
+    for (int i = 0; i < IO_READERS; i++)
+        pthread_create(&readers[i], NULL, reader_thread, NULL);
+    pthread_create(&writer, NULL, writer_thread, NULL);
+
+    // 1) 파일 인자는 순서대로 바로 넣고, 디렉터리는 탐색 풀이 찾는 대로 흘려보냄
+    gettimeofday(&archive_start, NULL);
+    char* roots[n > 0 ? n : 1];
+    int nroots = 0;
+    for (int i = 0; i < n; i++) {
+        struct stat st;
+        if (stat(paths[i], &st) < 0) {
+            perror(paths[i]);
+            return 1;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            roots[nroots++] = paths[i];
+        } else {
+            char* path = strdup(paths[i]);
+            if (!path) return 1;
+            add_archive_file(NULL, path, &st);
+        }
+    }
+    long dirs = 0;
+    if (nroots > 0 && walk_parallel(roots, nroots, DISCOVERY_THREADS, add_archive_file, NULL, &dirs, NULL) > 0) {
+        fprintf(stderr, "Directory traversal failed.\n");
+        return 1;
+    }
+    struct timeval discovered;
+    gettimeofday(&discovered, NULL);
+
+    // 2) 남은 해시가 끝나면 계획이 완성되고 전체 블록 수가 정해짐
+    pthread_mutex_lock(&pool_mutex);
+    while (hashes_done < file_count)
+        pthread_cond_wait(&hash_done, &pool_mutex);
+    total_blocks = planned_blocks;
+    pthread_cond_broadcast(&slot_free);
+    pthread_cond_signal(&block_done);
+    pthread_mutex_unlock(&pool_mutex);
+
+    // 3) 새 아카이브를 임시 파일에 다 쓰면 교체
+    void* ret;
+    pthread_join(writer, &ret);
+    pthread_mutex_lock(&pool_mutex);
+    pthread_cond_broadcast(&slot_free);
+    pthread_mutex_unlock(&pool_mutex);
+    for (int i = 0; i < IO_READERS; i++)
+        pthread_join(readers[i], NULL);
+    if (ret != NULL) return 1;
+    stop_workers(threads, thread_count);
+    if (emit_end_marker() < 0 || write_archive_index() < 0 || fsync(fd_out) < 0) return 1;
+
+    if (write_manifest(tmp_manifest) < 0 ||
+        rename(tmp_archive, archive) < 0 || rename(tmp_manifest, manifest) < 0) {
+        perror("rename failed");
+        return 1;
+    }
+    fprintf(stderr, "Files: %d (unchanged %d, compressed %d, %d not re-read: same size and mtime)\n", file_count,
+            unchanged_files, file_count - unchanged_files, rehash_skipped);
+    fprintf(stderr, "Discovery: %d files in %ld directories, done at %.3f ms", file_count, dirs,
+            elapsed_ms(&archive_start, &discovered));
+    if (total_blocks > 0)
+        fprintf(stderr, " (first block queued at %.3f ms)", elapsed_ms(&archive_start, &first_block_time));
+    fprintf(stderr, "\n");
+
+    if (prev_fd >= 0) close(prev_fd);
+    for (int i = 0; i < prev_count; i++) free(prev_ents[i].path);
+    free(prev_ents);
+    for (int i = 0; i < file_count; i++) free(file_at(i)->path);
+    for (int c = 0; c < MAX_CHUNKS && file_chunks[c]; c++) free(file_chunks[c]);
+    for (int c = 0; c < MAX_CHUNKS && plan_chunks[c]; c++) free(plan_chunks[c]);
+    free_pool();
+    return 0;
+}
+
+// 슬롯 버퍼를 최소 len 바이트로 (해제 중 압축 때의 블록 크기가 -b 보다 크면)
+static int reserve_slot(Block* b, size_t len) {
+    if (b->cap >= len) return 0;
+    len = (len + 4095) & ~(size_t)4095;
+    free(b->bufs[0]);
+    free(b->bufs[1]);
+    b->bufs[0] = b->bufs[1] = NULL;
+    if (posix_memalign((void**)&b->bufs[0], 4096, len) != 0 ||
+        posix_memalign((void**)&b->bufs[1], 4096, len) != 0)
+        return -1;
+    b->data = b->bufs[0];
+    b->work = b->bufs[1];
+    b->cap = len;
+    return 0;
+}
+
+// 블록 레코드 입력: stdin, 추출 중이면 mmap 된 아카이브의 남은 범위에서 복사
+static size_t read_records(uint8_t* buf, size_t len) {
+    if (!map_pos) return read_full(stdin, buf, len);
+    size_t n = (size_t)(map_end - map_pos) < len ? (size_t)(map_end - map_pos) : len;
+    memcpy(buf, map_pos, n);
+    map_pos += n;
+    return n;
+}
+
+// 블록 레코드를 순서대로 읽어 슬롯에 담고, 워커가 병렬로 복원하며 체크섬을 확인하고,
+// writer 가 원본을 순서대로 기록 (끝 표시, 또는 추출 범위의 끝까지)
+static int decode_records(int thread_count, size_t hdr_len) {
+    uint8_t hdr[BLOCK_HEADER];
+    decompressing = 1;
+    if (setup_pool(thread_count) < 0) return 1;
+    pthread_t threads[thread_count], writer;
+    start_workers(threads, thread_count);
+    pthread_create(&writer, NULL, writer_thread, NULL);
+
+    long seq = 0;
+    int rc = 1;
+    while (1) {
+        if (map_pos && map_pos == map_end) {
+            rc = 0;
+            break;
+        }
+        if (read_records(hdr, 4) != 4) {
+            fprintf(stderr, "Truncated stream.\n");
+            break;
+        }
+        uint32_t len = get_u32(hdr);
+        if (len == 0) {
+            rc = 0;
+            break;
+        }
+        if (read_records(hdr + 4, hdr_len - 4) != hdr_len - 4) {
+            fprintf(stderr, "Truncated block header.\n");
+            break;
+        }
+        uint32_t plen = get_u32(hdr + 9);
+        if (len > (uint32_t)MAX_BLOCK_KB * 1024 || plen > RLE_BOUND(len)) {
+            fprintf(stderr, "Corrupt block header.\n");
+            break;
+        }
+
+        pthread_mutex_lock(&pool_mutex);
+        while (free_count == 0)
+            pthread_cond_wait(&slot_free, &pool_mutex);
+        Block* b = free_slots[--free_count];
+        pthread_mutex_unlock(&pool_mutex);
+        if (reserve_slot(b, RLE_BOUND((size_t)len)) < 0) {
+            fprintf(stderr, "Out of memory for a block of %u bytes.\n", len);
+            break;
+        }
+        if (read_records(b->data, plen) != plen) {
+            fprintf(stderr, "Truncated block payload.\n");
+            break;
+        }
+        bytes_in += hdr_len + plen;
+        b->seq = seq++;
+        b->len = len;
+        b->method = hdr[4];
+        b->primary = get_u32(hdr + 5);
+        b->out_len = plen;
+        b->crc = stream_crc ? get_u32(hdr + 13) : 0;
+        b->stage = DECODE;
+        enqueue_block(b);
+    }
+
+    // 오류가 나도 이미 읽은 블록까지는 기록하고 끝냄
+    pthread_mutex_lock(&pool_mutex);
+    total_blocks = seq;
+    pthread_cond_signal(&block_done);
+    pthread_mutex_unlock(&pool_mutex);
+    void* ret;
+    pthread_join(writer, &ret);
+    stop_workers(threads, thread_count);
+    free_pool();
+    if (ret != NULL || fflush(stdout) != 0) rc = 1;
+    return rc;
+}
+
+// 해제 함수: 스트림 매직으로 형식을 확인하고 블록 레코드를 복원
+int run_stream_decompressor(int thread_count) {
+    uint8_t magic[4];
+    if (read_full(stdin, magic, 4) != 4 ||
+        (memcmp(magic, STREAM_MAGIC, 4) != 0 && memcmp(magic, LEGACY_MAGIC, 4) != 0)) {
+        fprintf(stderr, "Not a compressed stream.\n");
+        return 1;
+    }
+    stream_crc = memcmp(magic, STREAM_MAGIC, 4) == 0;
+    bytes_in += 4;
+    return decode_records(thread_count, stream_crc ? BLOCK_HEADER : LEGACY_HEADER);
+}
+
+// 색인에서 이름으로 항목을 찾음 (이름순 이진 탐색), 없으면 NULL
+static const uint8_t* find_index_entry(const uint8_t* index, uint32_t count, const char* names,
+                                       size_t names_len, const char* name) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const uint8_t* e = index + INDEX_HEADER + (size_t)mid * INDEX_ENTRY;
+        uint32_t off = get_u32(e + 36);
+        if (off >= names_len) return NULL;
+        int c = strcmp(names + off, name);
+        if (c == 0) return e;
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+// 추출 (-a archive -x name): 아카이브를 mmap 하고 꼬리에서 색인을 찾아
+// 파일 하나의 블록 레코드만 워커 풀로 복원 (읽는 양은 그 파일의 압축 크기에 비례)
+int run_extract(int thread_count, const char* archive, const char* name) {
+    int fd = open(archive, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror(archive);
+        return 1;
+    }
+    size_t size = st.st_size;
+    if (size < 4 + 4 + INDEX_HEADER + INDEX_TRAILER) {
+        fprintf(stderr, "Not an indexed archive.\n");
+        close(fd);
+        return 1;
+    }
+    const uint8_t* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap failed");
+        return 1;
+    }
+    int rc = 1;
+    const uint8_t* tail = map + size - INDEX_TRAILER;
+    uint64_t index_off = get_u64(tail);
+    if (memcmp(map, STREAM_MAGIC, 4) != 0 || memcmp(tail + 12, INDEX_TAIL_MAGIC, 4) != 0 ||
+        index_off < 8 || index_off > size - INDEX_TRAILER - INDEX_HEADER) {
+        fprintf(stderr, "Archive has no file index (created by an older version, use -d).\n");
+        goto out;
+    }
+    const uint8_t* index = map + index_off;
+    size_t index_len = size - INDEX_TRAILER - index_off;
+    uint32_t count = get_u32(index + 4);
+    if (memcmp(index, INDEX_MAGIC, 4) != 0 || (index_len - INDEX_HEADER) / INDEX_ENTRY < count ||
+        crc32c(0, index, index_len) != get_u32(tail + 8)) {
+        fprintf(stderr, "Corrupt archive index.\n");
+        goto out;
+    }
+    const char* names = (const char*)index + INDEX_HEADER + (size_t)count * INDEX_ENTRY;
+    size_t names_len = index_len - INDEX_HEADER - (size_t)count * INDEX_ENTRY;
+    if (count > 0 && (names_len == 0 || names[names_len - 1] != '\0')) {
+        fprintf(stderr, "Corrupt archive index.\n");
+        goto out;
+    }
+    const uint8_t* e = find_index_entry(index, count, names, names_len, name);
+    if (!e) {
+        fprintf(stderr, "%s: not in archive.\n", name);
+        goto out;
+    }
+    uint64_t off = get_u64(e), end = get_u64(e + 8);
+    uint32_t nblocks = get_u32(e + 28);
+    if (off > end || end > index_off || (nblocks > 0 && off < 4)) {
+        fprintf(stderr, "Corrupt archive index.\n");
+        goto out;
+    }
+    // 필요한 범위만 미리 읽어 달라고 알림 (페이지 정렬)
+    long page = sysconf(_SC_PAGESIZE);
+    uint64_t start = off & ~(uint64_t)(page - 1);
+    if (end > start) madvise((void*)(map + start), end - start, MADV_WILLNEED);
+    map_pos = map + off;
+    map_end = map + end;
+    extract_skip = get_u32(e + 32);
+    extract_left = get_u64(e + 16);
+    // 블록이 여러 개일 때만 여러 워커로 (작은 파일은 스레드를 띄우는 비용이 더 큼)
+    int T = nblocks < (uint32_t)thread_count ? (nblocks > 0 ? (int)nblocks : 1) : thread_count;
+    rc = decode_records(T, BLOCK_HEADER);
+    if (rc == 0 && extract_left != 0) {
+        fprintf(stderr, "%s: archive data is shorter than its index entry.\n", name);
+        rc = 1;
+    }
+out:
+    munmap((void*)map, size);
+    map_pos = map_end = NULL;
+    return rc;
+}
+
+// -K: 체크섬 커널별 처리량 (GB/s)
+int run_crc_bench() {
+    uint8_t* buf = malloc(CRC_BENCH_BYTES);
+    if (!buf) {
+        fprintf(stderr, "Out of memory for the checksum benchmark.\n");
+        return 1;
+    }
+    uint64_t x = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < CRC_BENCH_BYTES; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        buf[i] = (uint8_t)x;
+    }
+    crc32c_init();
+    struct {
+        const char* name;
+        uint32_t (*fn)(uint32_t, const void*, size_t);
+        int reps;
+    } kernels[] = {
+        { "bytewise table", crc32c_bytewise, 1 },
+        { "slicing-by-8", crc32c_sw, 4 },
+#if defined(__x86_64__)
+        { "sse4.2 1-way", crc32c_hw1, 8 },
+        { "sse4.2 3-way", crc32c_hw, 16 },
+#endif
+    };
+    uint32_t expect = crc32c_bytewise(0, buf, CRC_BENCH_BYTES);
+    int rc = 0;
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (k >= 2 && !crc32c_has_hw) break;
+        struct timeval t0, t1;
+        uint32_t c = 0;
+        gettimeofday(&t0, NULL);
+        for (int r = 0; r < kernels[k].reps; r++)
+            c = kernels[k].fn(0, buf, CRC_BENCH_BYTES);
+        gettimeofday(&t1, NULL);
+        double sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) / 1e6;
+        printf("%-16s %8.2f GB/s  crc %08x%s\n", kernels[k].name,
+            sec > 0 ? (double)CRC_BENCH_BYTES * kernels[k].reps / sec / 1e9 : 0.0, c, c == expect ? "" : "  MISMATCH");
+        if (c != expect) rc = 1;
+    }
+    free(buf);
+    return rc;
+}
+
+int main(int argc, char* argv[]) {
+    int decompress = 0, direct = 0, crc_bench = 0;
+    int T = 1;
+    const char* in_path = NULL, * out_path = NULL, * archive = NULL, * extract = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "dt:b:i:o:DSLFHMKa:x:")) != -1) {
+        switch (opt) {
+        case 'd': decompress = 1; break;
+        case 't': T = atoi(optarg); break;
+        case 'b': block_size = atoi(optarg) * 1024; break;
+        case 'i': in_path = optarg; break;
+        case 'o': out_path = optarg; break;
+        case 'D': direct = 1; break;       // 입력을 O_DIRECT 로 (페이지 캐시 미사용 측정)
+        case 'S': force_pread = 1; break;  // io_uring 대신 pread 풀 사용
+        case 'H': work_mode = WORK_HUGETLB; break;
+        case 'M': work_mode = WORK_MALLOC; break;
+        case 'L': fast_lz = 1; break;      // 중간 정도로 압축되는 블록은 BWT 대신 LZ
+        case 'F': fused_mtf_rle = 1; break;  // MTF+RLE 를 한 단계로
+        case 'a': archive = optarg; break;
+        case 'x': extract = optarg; break;  // -a 의 아카이브에서 파일 하나만 추출
+        case 'K': crc_bench = 1; break;    // 체크섬 커널 벤치마크만 실행
+        default:
+            fprintf(stderr, "Usage: %s [-d] [-t thread_count] [-b block_kb] [-L] [-F] [-H|-M] [-i input -o output [-D] [-S]]\n", argv[0]);
+            fprintf(stderr, "       %s -a archive [-t thread_count] [-b block_kb] [-L] [-F] [-H|-M] file|dir...\n", argv[0]);
+            fprintf(stderr, "       %s -a archive -x name [-t thread_count] [-o output]\n", argv[0]);
+            fprintf(stderr, "       %s -K    (CRC32C kernel benchmark)\n", argv[0]);
+            fprintf(stderr, "       without -i/-o reads stdin and writes stdout\n");
+            return 1;
+        }
+    }
+    if (crc_bench) return run_crc_bench();
+    if (T <= 0) {
+        fprintf(stderr, "Invalid thread_count (must be ≥ 1).\n");
+        return 1;
+    }
+    if (block_size <= 0 || block_size > MAX_BLOCK_KB * 1024) {
+        fprintf(stderr, "Invalid block size (1 ~ %d KB).\n", MAX_BLOCK_KB);
+        return 1;
+    }
+    if (direct && (in_path == NULL || block_size % 4096 != 0)) {
+        fprintf(stderr, "-D needs -i and a block size that is a multiple of 4 KB.\n");
+        return 1;
+    }
+
+    if (extract && (!archive || decompress || in_path)) {
+        fprintf(stderr, "-x needs -a and cannot be combined with -d or -i.\n");
+        return 1;
+    }
+    if (archive && !extract && (decompress || in_path || out_path)) {
+        fprintf(stderr, "-a cannot be combined with -d, -i or -o.\n");
+        return 1;
+    }
+
+    if (decompress || extract) {
+        decompressing = 1;
+        if ((in_path && !freopen(in_path, "rb", stdin)) || (out_path && !freopen(out_path, "wb", stdout))) {
+            perror("open failed");
+            return 1;
+        }
+    } else {
+        if (in_path && (fd_in = open(in_path, O_RDONLY | (direct ? O_DIRECT : 0))) < 0) {
+            perror(in_path);
+            return 1;
+        }
+        if (out_path && (fd_out = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+            perror(out_path);
+            return 1;
+        }
+    }
+
+    PerfMetrics metrics;
+    start_perf(&metrics);
+    int rc;
+    if (extract)
+        rc = run_extract(T, archive, extract);
+    else if (archive)
+        rc = run_archive_compressor(T, archive, argv + optind, argc - optind);
+    else
+        rc = decompress ? run_stream_decompressor(T) : run_stream_compressor(T);
+    end_perf(&metrics, 0);
+
+    fprint_perf_summary(stderr, &metrics);
+    fprintf(stderr, "Bytes in / out:         %lld / %lld", bytes_in, bytes_out);
+    if (bytes_in > 0)
+        fprintf(stderr, " (%.2f %%)", 100.0 * bytes_out / bytes_in);
+    fprintf(stderr, "\n");
+    if (!decompressing)
+        fprintf(stderr, "Probe stored / LZ:      %ld / %ld blocks\n", probe_stored, probe_lz);
+    if (decompressing)
+        fprintf(stderr, "Checksums verified:     %ld blocks%s\n", crc_verified, stream_crc ? "" : " (legacy stream, none stored)");
+    if (!decompressing && work_kind >= 0) {
+        static const char* kinds[] = { "4K pages", "THP", "hugetlbfs" };
+        fprintf(stderr, "BWT work memory:        per-thread pool (%s)\n", kinds[work_kind]);
+    }
+    if (fd_in >= 0) close(fd_in);
+    if (fd_out >= 0 && close(fd_out) < 0) {
+        perror("close failed");
+        rc = 1;
+    }
+    return rc;
+}
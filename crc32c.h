@@ -0,0 +1,199 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+// CRC32C (Castagnoli): 블록 무결성 검사용
+// SSE4.2 가 있으면 crc32 명령을 세 갈래로 교차 실행 (명령 지연 3 사이클을 숨김),
+// 없으면 slicing-by-8 테이블
+
+#define CRC32C_POLY 0x82f63b78u  // 반사된 다항식
+#define CRC32C_LONG 8192         // 3-way 한 갈래 길이 (2 의 거듭제곱)
+#define CRC32C_SHORT 256
+
+static uint32_t crc32c_table[8][256];
+static uint32_t crc32c_long[4][256], crc32c_short[4][256];  // 갈래 길이만큼 0 을 통과시키는 연산자
+static int crc32c_has_hw = 0;
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+// GF(2) 32x32 행렬 * 벡터
+static inline uint32_t crc32c_gf2_times(const uint32_t* mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) sum ^= *mat;
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+static inline void crc32c_gf2_square(uint32_t* square, const uint32_t* mat) {
+    for (int n = 0; n < 32; n++)
+        square[n] = crc32c_gf2_times(mat, mat[n]);
+}
+
+// len(2 의 거듭제곱) 바이트의 0 을 CRC 에 통과시키는 연산자를 바이트별 표로
+static inline void crc32c_zeros(uint32_t zeros[][256], size_t len) {
+    uint32_t even[32], odd[32];
+    odd[0] = CRC32C_POLY;  // 0 비트 하나
+    for (int n = 1; n < 32; n++)
+        odd[n] = 1u << (n - 1);
+    crc32c_gf2_square(even, odd);  // 2 비트
+    crc32c_gf2_square(odd, even);  // 4 비트
+    uint32_t* op = even;
+    while (1) {
+        crc32c_gf2_square(even, odd);  // 처음에는 8 비트 = 1 바이트
+        op = even;
+        len >>= 1;
+        if (len == 0) break;
+        crc32c_gf2_square(odd, even);
+        op = odd;
+        len >>= 1;
+        if (len == 0) break;
+    }
+    for (int n = 0; n < 256; n++) {
+        zeros[0][n] = crc32c_gf2_times(op, n);
+        zeros[1][n] = crc32c_gf2_times(op, n << 8);
+        zeros[2][n] = crc32c_gf2_times(op, n << 16);
+        zeros[3][n] = crc32c_gf2_times(op, (uint32_t)n << 24);
+    }
+}
+
+static inline uint32_t crc32c_shift(uint32_t zeros[][256], uint32_t crc) {
+    return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+        zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+static void crc32c_init_once(void) {
+    for (int n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+        crc32c_table[0][n] = c;
+    }
+    for (int n = 0; n < 256; n++)
+        for (int k = 1; k < 8; k++)
+            crc32c_table[k][n] = (crc32c_table[k - 1][n] >> 8) ^ crc32c_table[0][crc32c_table[k - 1][n] & 0xff];
+    crc32c_zeros(crc32c_long, CRC32C_LONG);
+    crc32c_zeros(crc32c_short, CRC32C_SHORT);
+#if defined(__x86_64__)
+    crc32c_has_hw = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+static inline void crc32c_init(void) {
+    pthread_once(&crc32c_once, crc32c_init_once);
+}
+
+// 한 바이트씩 (벤치마크 기준선)
+static inline uint32_t crc32c_bytewise(uint32_t crc, const void* buf, size_t len) {
+    const uint8_t* p = buf;
+    crc = ~crc;
+    while (len--)
+        crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *p++) & 0xff];
+    return ~crc;
+}
+
+// slicing-by-8: 8 바이트를 표 8 개로 한 번에 (little-endian 호스트 가정)
+static inline uint32_t crc32c_sw(uint32_t crc, const void* buf, size_t len) {
+    const uint8_t* p = buf;
+    crc = ~crc;
+    while (len && ((uintptr_t)p & 7)) {
+        crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *p++) & 0xff];
+        len--;
+    }
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        w ^= crc;
+        crc = crc32c_table[7][w & 0xff] ^ crc32c_table[6][(w >> 8) & 0xff] ^
+            crc32c_table[5][(w >> 16) & 0xff] ^ crc32c_table[4][(w >> 24) & 0xff] ^
+            crc32c_table[3][(w >> 32) & 0xff] ^ crc32c_table[2][(w >> 40) & 0xff] ^
+            crc32c_table[1][(w >> 48) & 0xff] ^ crc32c_table[0][w >> 56];
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *p++) & 0xff];
+    return ~crc;
+}
+
+#if defined(__x86_64__)
+// SSE4.2 한 갈래 (명령 하나가 끝나야 다음 명령을 시작, 벤치마크 비교용)
+__attribute__((target("sse4.2"), unused))
+static uint32_t crc32c_hw1(uint32_t crc, const void* buf, size_t len) {
+    const uint8_t* p = buf;
+    uint64_t c = ~crc;
+    while (len && ((uintptr_t)p & 7)) {
+        c = _mm_crc32_u8(c, *p++);
+        len--;
+    }
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        c = _mm_crc32_u64(c, w);
+    }
+    while (len--)
+        c = _mm_crc32_u8(c, *p++);
+    return ~(uint32_t)c;
+}
+
+// SSE4.2 세 갈래: 연속된 세 구간을 독립적으로 돌리고 0 통과 연산자로 합침
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, const void* buf, size_t len) {
+    const uint8_t* p = buf;
+    uint64_t c0 = ~crc;
+    while (len && ((uintptr_t)p & 7)) {
+        c0 = _mm_crc32_u8(c0, *p++);
+        len--;
+    }
+    static const size_t lanes[2] = { CRC32C_LONG, CRC32C_SHORT };
+    for (int l = 0; l < 2; l++) {
+        size_t lane = lanes[l];
+        while (len >= 3 * lane) {
+            uint64_t c1 = 0, c2 = 0;
+            const uint8_t* end = p + lane;
+            do {
+                uint64_t a, b, d;
+                memcpy(&a, p, 8);
+                memcpy(&b, p + lane, 8);
+                memcpy(&d, p + 2 * lane, 8);
+                c0 = _mm_crc32_u64(c0, a);
+                c1 = _mm_crc32_u64(c1, b);
+                c2 = _mm_crc32_u64(c2, d);
+                p += 8;
+            } while (p < end);
+            uint32_t (*zeros)[256] = l == 0 ? crc32c_long : crc32c_short;
+            c0 = crc32c_shift(zeros, (uint32_t)c0) ^ c1;
+            c0 = crc32c_shift(zeros, (uint32_t)c0) ^ c2;
+            p += 2 * lane;
+            len -= 3 * lane;
+        }
+    }
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        c0 = _mm_crc32_u64(c0, w);
+    }
+    while (len--)
+        c0 = _mm_crc32_u8(c0, *p++);
+    return ~(uint32_t)c0;
+}
+#endif
+
+// crc 에 이어서 계산 (처음이면 0)
+static inline uint32_t crc32c(uint32_t crc, const void* buf, size_t len) {
+    crc32c_init();
+#if defined(__x86_64__)
+    if (crc32c_has_hw) return crc32c_hw(crc, buf, len);
+#endif
+    return crc32c_sw(crc, buf, len);
+}
+
+#endif
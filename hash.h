@@ -0,0 +1,135 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// XXH64 (스트리밍): 매니페스트의 파일 내용 해시용
+
+#define XXH_P1 11400714785074694791ULL
+#define XXH_P2 14029467366897019727ULL
+#define XXH_P3 1609587929392839161ULL
+#define XXH_P4 9650029242287828579ULL
+#define XXH_P5 2870177450012600261ULL
+
+typedef struct {
+    uint64_t v[4];
+    uint64_t total_len;
+    uint8_t buf[32];
+    int buf_len;
+    uint64_t seed;
+} Xxh64;
+
+static inline uint64_t xxh_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);  // little-endian 호스트 가정
+    return v;
+}
+
+static inline uint32_t xxh_read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_P2;
+    acc = xxh_rotl(acc, 31);
+    return acc * XXH_P1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * XXH_P1 + XXH_P4;
+}
+
+static inline void xxh64_init(Xxh64* s, uint64_t seed) {
+    memset(s, 0, sizeof(*s));
+    s->seed = seed;
+    s->v[0] = seed + XXH_P1 + XXH_P2;
+    s->v[1] = seed + XXH_P2;
+    s->v[2] = seed;
+    s->v[3] = seed - XXH_P1;
+}
+
+static inline void xxh64_stripe(Xxh64* s, const uint8_t* p) {
+    s->v[0] = xxh_round(s->v[0], xxh_read64(p));
+    s->v[1] = xxh_round(s->v[1], xxh_read64(p + 8));
+    s->v[2] = xxh_round(s->v[2], xxh_read64(p + 16));
+    s->v[3] = xxh_round(s->v[3], xxh_read64(p + 24));
+}
+
+static inline void xxh64_update(Xxh64* s, const void* data, size_t len) {
+    const uint8_t* p = data;
+    s->total_len += len;
+    if (s->buf_len + len < 32) {
+        memcpy(s->buf + s->buf_len, p, len);
+        s->buf_len += len;
+        return;
+    }
+    if (s->buf_len > 0) {
+        size_t fill = 32 - s->buf_len;
+        memcpy(s->buf + s->buf_len, p, fill);
+        xxh64_stripe(s, s->buf);
+        p += fill;
+        len -= fill;
+        s->buf_len = 0;
+    }
+    while (len >= 32) {
+        xxh64_stripe(s, p);
+        p += 32;
+        len -= 32;
+    }
+    memcpy(s->buf, p, len);
+    s->buf_len = len;
+}
+
+static inline uint64_t xxh64_digest(const Xxh64* s) {
+    uint64_t h;
+    if (s->total_len >= 32) {
+        h = xxh_rotl(s->v[0], 1) + xxh_rotl(s->v[1], 7) + xxh_rotl(s->v[2], 12) + xxh_rotl(s->v[3], 18);
+        for (int i = 0; i < 4; i++) h = xxh_merge(h, s->v[i]);
+    } else {
+        h = s->seed + XXH_P5;
+    }
+    h += s->total_len;
+
+    const uint8_t* p = s->buf;
+    int len = s->buf_len;
+    while (len >= 8) {
+        h ^= xxh_round(0, xxh_read64(p));
+        h = xxh_rotl(h, 27) * XXH_P1 + XXH_P4;
+        p += 8;
+        len -= 8;
+    }
+    if (len >= 4) {
+        h ^= (uint64_t)xxh_read32(p) * XXH_P1;
+        h = xxh_rotl(h, 23) * XXH_P2 + XXH_P3;
+        p += 4;
+        len -= 4;
+    }
+    while (len-- > 0) {
+        h ^= (*p++) * XXH_P5;
+        h = xxh_rotl(h, 11) * XXH_P1;
+    }
+    h ^= h >> 33;
+    h *= XXH_P2;
+    h ^= h >> 29;
+    h *= XXH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t xxh64(const void* data, size_t len, uint64_t seed) {
+    Xxh64 s;
+    xxh64_init(&s, seed);
+    xxh64_update(&s, data, len);
+    return xxh64_digest(&s);
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef HUGEPOOL_H
+#define HUGEPOOL_H
+
+#include <sys/mman.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+// 스레드별 작업 메모리: 한 번 mmap 해서 huge page 로 잡고 미리 fault 시켜 둔 뒤
+// 작업마다 재사용 (작업마다 malloc/free 하면 큰 배열은 매번 mmap/munmap + page fault)
+
+#define HUGE_PAGE_SIZE (2u << 20)
+
+enum { HUGE_NONE = 0, HUGE_THP = 1, HUGE_TLBFS = 2 };
+
+typedef struct {
+    uint8_t* base;
+    size_t len;
+    int kind;  // HUGE_NONE / HUGE_THP / HUGE_TLBFS
+} HugeBuf;
+
+// 예약된 hugetlbfs 페이지가 있으면 MAP_HUGETLB, 없으면 THP(MADV_HUGEPAGE),
+// 그것도 안 되면 일반 페이지. 어느 경우든 페이지마다 한 번씩 써서 미리 fault
+static inline int hugebuf_map(HugeBuf* b, size_t len, int try_hugetlb) {
+    len = (len + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+    b->base = NULL;
+    b->len = 0;
+    b->kind = HUGE_NONE;
+    void* p = MAP_FAILED;
+    if (try_hugetlb) {
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        if (p != MAP_FAILED) b->kind = HUGE_TLBFS;
+    }
+    if (p == MAP_FAILED) {
+        // 2MB 경계에 맞춰야 THP 가 전부 huge page 로 채워지므로 여유를 두고 잡아서 잘라냄
+        size_t span = len + HUGE_PAGE_SIZE;
+        uint8_t* raw = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) return -1;
+        uint8_t* aligned = (uint8_t*)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+        if (aligned > raw) munmap(raw, aligned - raw);
+        if (raw + span > aligned + len) munmap(aligned + len, raw + span - (aligned + len));
+        p = aligned;
+        if (madvise(p, len, MADV_HUGEPAGE) == 0) b->kind = HUGE_THP;
+        long page = sysconf(_SC_PAGESIZE);
+        for (size_t off = 0; off < len; off += page)
+            ((volatile uint8_t*)p)[off] = 0;
+    }
+    b->base = p;
+    b->len = len;
+    return 0;
+}
+
+static inline void hugebuf_unmap(HugeBuf* b) {
+    if (b->base) munmap(b->base, b->len);
+    b->base = NULL;
+    b->len = 0;
+}
+
+// 최소 len 바이트를 보장 (부족할 때만 다시 매핑, 내용은 보존하지 않음)
+static inline void* hugebuf_reserve(HugeBuf* b, size_t len, int try_hugetlb) {
+    if (b->len >= len) return b->base;
+    hugebuf_unmap(b);
+    return hugebuf_map(b, len, try_hugetlb) == 0 ? b->base : NULL;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef LATCH_H
+#define LATCH_H
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// 완료 추적: 카운트다운 래치 하나 + (필요하면) 워커별 완료 통계
+//   래치는 원자적 감소 한 번, 0 이 되는 순간에만 futex 로 기다리는 쪽을 깨움
+//   워커별 통계는 자기 칸만 갱신하고 (캐시 라인 하나씩 차지해서 false sharing 없음)
+//   래치가 풀린 뒤에 기다리던 쪽이 읽음 (실행 중 진행 상황은 metrics.h 의 WorkerMetrics)
+//   기다리는 쪽은 값이 바뀔 때까지 커널에서 잠들므로 폴링하지 않음
+
+#define CACHE_LINE 64
+
+typedef struct {
+    long files;     // 끝낸 작업에 담긴 파일 수 (solid 작업은 여러 개)
+    double sum_ms;  // 파일별 완료 시각의 합과 최대 (run.c hybrid 통계)
+    double max_ms;
+} __attribute__((aligned(CACHE_LINE))) WorkerCounter;
+
+static inline WorkerCounter* worker_counters_create(int n) {
+    WorkerCounter* c = aligned_alloc(CACHE_LINE, sizeof(WorkerCounter) * n);
+    if (c) memset(c, 0, sizeof(WorkerCounter) * n);
+    return c;
+}
+
+typedef struct {
+    int remaining;  // futex 워드 (프로세스 내부 전용)
+} Latch;
+
+static inline void latch_init(Latch* l, int count) {
+    __atomic_store_n(&l->remaining, count, __ATOMIC_RELEASE);
+}
+
+// n 개 완료: 마지막으로 0 을 만든 워커만 시스템 콜을 부름
+static inline void latch_count_down(Latch* l, int n) {
+    if (__atomic_sub_fetch(&l->remaining, n, __ATOMIC_ACQ_REL) == 0)
+        syscall(SYS_futex, &l->remaining, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+// 0 이 될 때까지 잠듦 (값이 이미 바뀌었으면 FUTEX_WAIT 가 바로 돌아옴)
+static inline void latch_wait(Latch* l) {
+    int v;
+    while ((v = __atomic_load_n(&l->remaining, __ATOMIC_ACQUIRE)) > 0)
+        syscall(SYS_futex, &l->remaining, FUTEX_WAIT_PRIVATE, v, NULL, NULL, 0);
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef LOCKSTAT_H
+#define LOCKSTAT_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+
+// 잠금 경합 프로파일링: -DLOCKSTAT 로 컴파일할 때만 측정
+//   호출 위치(site)마다 칸 하나: 획득 횟수, 경합 횟수 (trylock 실패), 기다린 시간, 잡고 있던 시간
+//   칸은 그 잠금을 잡은 스레드만 갱신하므로 따로 원자 연산이 필요 없음
+//   잡고 있던 시간에서 조건 변수 대기는 뺌 (그동안은 잠금이 풀려 있음)
+//   꺼져 있으면 pthread 호출 그대로 (칸 인자는 쓰이지 않고 사라짐)
+
+#ifdef LOCKSTAT
+#define LOCKSTAT_ENABLED 1
+#else
+#define LOCKSTAT_ENABLED 0
+#endif
+
+#define LOCKSTAT_MAX_SITES 8
+
+typedef struct {
+    long acquisitions;
+    long contended;
+    long long wait_ns;
+    long long hold_ns;
+    long long held_since;  // 잡은 시각 (잡고 있는 동안만 의미 있음)
+} LockStat;
+
+static inline long long lockstat_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline void lockstat_lock(pthread_mutex_t* m, LockStat* s) {
+#if LOCKSTAT_ENABLED
+    long long t0 = 0;
+    int contended = pthread_mutex_trylock(m) != 0;
+    if (contended) {
+        t0 = lockstat_now_ns();
+        pthread_mutex_lock(m);
+    }
+    s->held_since = lockstat_now_ns();
+    s->acquisitions++;
+    if (contended) {
+        s->contended++;
+        s->wait_ns += s->held_since - t0;
+    }
+#else
+    (void)s;
+    pthread_mutex_lock(m);
+#endif
+}
+
+static inline void lockstat_unlock(pthread_mutex_t* m, LockStat* s) {
+#if LOCKSTAT_ENABLED
+    s->hold_ns += lockstat_now_ns() - s->held_since;
+#else
+    (void)s;
+#endif
+    pthread_mutex_unlock(m);
+}
+
+// 조건 변수 대기: 잠금이 풀려 있는 동안은 잡고 있던 시간에서 뺌
+static inline void lockstat_cond_wait(pthread_cond_t* c, pthread_mutex_t* m, LockStat* s) {
+#if LOCKSTAT_ENABLED
+    s->hold_ns += lockstat_now_ns() - s->held_since;
+    pthread_cond_wait(c, m);
+    s->held_since = lockstat_now_ns();
+#else
+    (void)s;
+    pthread_cond_wait(c, m);
+#endif
+}
+
+static inline void lockstat_cond_timedwait(pthread_cond_t* c, pthread_mutex_t* m,
+    const struct timespec* ts, LockStat* s) {
+#if LOCKSTAT_ENABLED
+    s->hold_ns += lockstat_now_ns() - s->held_since;
+    pthread_cond_timedwait(c, m, ts);
+    s->held_since = lockstat_now_ns();
+#else
+    (void)s;
+    pthread_cond_timedwait(c, m, ts);
+#endif
+}
+
+// 프로세스별 칸을 합산 (hybrid 모드에서 부모가 자식 몫을 모음)
+static inline void lockstat_merge(LockStat* into, const LockStat* from, int n) {
+    for (int i = 0; i < n; i++) {
+        into[i].acquisitions += from[i].acquisitions;
+        into[i].contended += from[i].contended;
+        into[i].wait_ns += from[i].wait_ns;
+        into[i].hold_ns += from[i].hold_ns;
+    }
+}
+
+// names[i] 는 "잠금/호출 위치" 형태
+static inline void lockstat_print(FILE* out, const LockStat* s, const char* const* names, int n) {
+    fprintf(out, "\nLock profile:              acquired   contended     wait ms     hold ms\n");
+    for (int i = 0; i < n; i++) {
+        if (s[i].acquisitions == 0) continue;
+        fprintf(out, "  %-22s %11ld %11ld %11.3f %11.3f  (%.2f%% contended, %.0f ns avg hold)\n", names[i],
+            s[i].acquisitions, s[i].contended, s[i].wait_ns / 1e6, s[i].hold_ns / 1e6,
+            100.0 * s[i].contended / s[i].acquisitions, (double)s[i].hold_ns / s[i].acquisitions);
+    }
+}
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// 실행 중 지표: 모든 프로세스가 fork 전에 만든 공유 페이지 한 장에 자기 칸만 기록하고,
+// 부모의 서버 스레드가 Unix 소켓 요청마다 잠금 없이 읽어서 Prometheus 텍스트 형식으로 응답
+//   프로세스 칸: 단계별 넣은/꺼낸 작업 수, 큐 깊이, 큐 잠금 횟수 (큐 뮤텍스 안에서 갱신)
+//   워커 칸: 단계별 끝낸 작업 수, 바쁜 시간, 입출력 바이트 (그 워커만 갱신)
+// 값은 relaxed atomic 으로 쓰고 읽으므로 읽는 쪽이 작업 경로를 막지 않음 (칸 사이의 순간 불일치는 허용)
+
+#define METRICS_STAGES 3
+#define METRICS_POLL_MS 200  // 서버 스레드가 종료 요청을 확인하는 주기
+
+typedef struct {
+    long enqueued[METRICS_STAGES];  // 단계별로 큐에 넣은 작업 수
+    long dequeued[METRICS_STAGES];  // 단계별로 꺼낸 작업 수
+    long ready_depth, pending_depth;
+    long locks;  // 큐 뮤텍스 획득 횟수
+} __attribute__((aligned(64))) ProcMetrics;
+
+typedef struct {
+    long done[METRICS_STAGES];  // 단계별로 끝낸 작업 수
+    long long busy_ns;          // 작업을 처리한 시간
+    long long bytes_in, bytes_out;
+} __attribute__((aligned(64))) WorkerMetrics;
+
+typedef struct {
+    int procs, workers;
+    long files;               // 전체 작업 수
+    struct timespec start;    // CLOCK_MONOTONIC
+} __attribute__((aligned(64))) MetricsHeader;
+
+typedef struct {
+    MetricsHeader* hdr;  // 공유 페이지 (헤더 | 프로세스 칸 | 워커 칸)
+    ProcMetrics* proc;
+    WorkerMetrics* worker;
+    size_t len;
+    const char* const* stage_names;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    int fd;
+    int stop;
+    pthread_t tid;
+} MetricsPage;
+
+static inline long long metrics_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// 칸의 주인(또는 그 칸의 잠금을 잡은 쪽)만 호출
+static inline void metrics_add(long* p, long n) {
+    __atomic_store_n(p, *p + n, __ATOMIC_RELAXED);
+}
+
+static inline void metrics_add_ll(long long* p, long long n) {
+    __atomic_store_n(p, *p + n, __ATOMIC_RELAXED);
+}
+
+static inline void metrics_set(long* p, long v) {
+    __atomic_store_n(p, v, __ATOMIC_RELAXED);
+}
+
+// 공유 페이지 생성 (fork 전에 호출), 실패하면 -1
+static inline int metrics_create(MetricsPage* m, int procs, int workers, long files, const char* const* stage_names) {
+    size_t len = sizeof(MetricsHeader) + sizeof(ProcMetrics) * procs + sizeof(WorkerMetrics) * procs * workers;
+    void* p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return -1;
+    m->hdr = p;
+    m->proc = (ProcMetrics*)(m->hdr + 1);
+    m->worker = (WorkerMetrics*)(m->proc + procs);
+    m->len = len;
+    m->stage_names = stage_names;
+    m->hdr->procs = procs;
+    m->hdr->workers = workers;
+    m->hdr->files = files;
+    clock_gettime(CLOCK_MONOTONIC, &m->hdr->start);
+    m->fd = -1;
+    return 0;
+}
+
+static inline WorkerMetrics* metrics_worker(const MetricsPage* m, int proc, int worker) {
+    return &m->worker[proc * m->hdr->workers + worker];
+}
+
+static inline long metrics_load(const long* p) {
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+// 현재 값을 Prometheus 텍스트 형식으로 (반환값은 malloc 된 문자열, 실패하면 NULL)
+static inline char* metrics_format(const MetricsPage* m, size_t* out_len) {
+    char* buf = NULL;
+    size_t len = 0;
+    FILE* f = open_memstream(&buf, &len);
+    if (!f) return NULL;
+    const MetricsHeader* h = m->hdr;
+    double uptime = (metrics_now_ns() - (h->start.tv_sec * 1000000000LL + h->start.tv_nsec)) / 1e9;
+    fprintf(f, "# HELP pfc_uptime_seconds Time since the metrics page was created.\n# TYPE pfc_uptime_seconds gauge\n");
+    fprintf(f, "pfc_uptime_seconds %.3f\n", uptime);
+    fprintf(f, "# HELP pfc_files Tasks in the workload.\n# TYPE pfc_files gauge\npfc_files %ld\n", h->files);
+
+    // 단계별: 대기 = 넣은 수 - 꺼낸 수, 처리 중 = 꺼낸 수 - 끝낸 수
+    long done[h->procs][METRICS_STAGES];
+    memset(done, 0, sizeof(done));
+    long long in[h->procs], out[h->procs];
+    for (int p = 0; p < h->procs; p++) {
+        in[p] = out[p] = 0;
+        for (int w = 0; w < h->workers; w++) {
+            const WorkerMetrics* wm = metrics_worker(m, p, w);
+            for (int s = 0; s < METRICS_STAGES; s++)
+                done[p][s] += metrics_load(&wm->done[s]);
+            in[p] += __atomic_load_n(&wm->bytes_in, __ATOMIC_RELAXED);
+            out[p] += __atomic_load_n(&wm->bytes_out, __ATOMIC_RELAXED);
+        }
+    }
+    fprintf(f, "# HELP pfc_stage_tasks Tasks per stage that are waiting in a queue or being processed.\n# TYPE pfc_stage_tasks gauge\n");
+    for (int p = 0; p < h->procs; p++) {
+        for (int s = 0; s < METRICS_STAGES; s++) {
+            long enq = metrics_load(&m->proc[p].enqueued[s]), deq = metrics_load(&m->proc[p].dequeued[s]);
+            long queued = enq - deq, running = deq - done[p][s];
+            fprintf(f, "pfc_stage_tasks{proc=\"%d\",stage=\"%s\",state=\"queued\"} %ld\n", p, m->stage_names[s], queued > 0 ? queued : 0);
+            fprintf(f, "pfc_stage_tasks{proc=\"%d\",stage=\"%s\",state=\"running\"} %ld\n", p, m->stage_names[s], running > 0 ? running : 0);
+        }
+    }
+    fprintf(f, "# HELP pfc_stage_done_total Tasks that finished each stage.\n# TYPE pfc_stage_done_total counter\n");
+    for (int p = 0; p < h->procs; p++)
+        for (int s = 0; s < METRICS_STAGES; s++)
+            fprintf(f, "pfc_stage_done_total{proc=\"%d\",stage=\"%s\"} %ld\n", p, m->stage_names[s], done[p][s]);
+    fprintf(f, "# HELP pfc_bytes_in_total Task buffer bytes of finished tasks.\n# TYPE pfc_bytes_in_total counter\n");
+    for (int p = 0; p < h->procs; p++)
+        fprintf(f, "pfc_bytes_in_total{proc=\"%d\"} %lld\n", p, in[p]);
+    fprintf(f, "# HELP pfc_bytes_out_total Output bytes of finished tasks.\n# TYPE pfc_bytes_out_total counter\n");
+    for (int p = 0; p < h->procs; p++)
+        fprintf(f, "pfc_bytes_out_total{proc=\"%d\"} %lld\n", p, out[p]);
+    fprintf(f, "# HELP pfc_queue_depth Entries in each task queue.\n# TYPE pfc_queue_depth gauge\n");
+    for (int p = 0; p < h->procs; p++) {
+        fprintf(f, "pfc_queue_depth{proc=\"%d\",queue=\"ready\"} %ld\n", p, metrics_load(&m->proc[p].ready_depth));
+        fprintf(f, "pfc_queue_depth{proc=\"%d\",queue=\"pending\"} %ld\n", p, metrics_load(&m->proc[p].pending_depth));
+    }
+    fprintf(f, "# HELP pfc_lock_acquisitions_total Acquisitions of the per-process queue_mutex.\n# TYPE pfc_lock_acquisitions_total counter\n");
+    for (int p = 0; p < h->procs; p++)
+        fprintf(f, "pfc_lock_acquisitions_total{proc=\"%d\",lock=\"queue_mutex\"} %ld\n", p, metrics_load(&m->proc[p].locks));
+    fprintf(f, "# HELP pfc_worker_busy_seconds_total Time each worker spent processing tasks.\n# TYPE pfc_worker_busy_seconds_total counter\n");
+    for (int p = 0; p < h->procs; p++)
+        for (int w = 0; w < h->workers; w++)
+            fprintf(f, "pfc_worker_busy_seconds_total{proc=\"%d\",worker=\"%d\"} %.6f\n", p, w,
+                    __atomic_load_n(&metrics_worker(m, p, w)->busy_ns, __ATOMIC_RELAXED) / 1e9);
+    fprintf(f, "# HELP pfc_worker_utilization Busy time divided by uptime.\n# TYPE pfc_worker_utilization gauge\n");
+    for (int p = 0; p < h->procs; p++) {
+        for (int w = 0; w < h->workers; w++) {
+            long long b = __atomic_load_n(&metrics_worker(m, p, w)->busy_ns, __ATOMIC_RELAXED);
+            fprintf(f, "pfc_worker_utilization{proc=\"%d\",worker=\"%d\"} %.4f\n", p, w, uptime > 0 ? b / 1e9 / uptime : 0.0);
+        }
+    }
+    if (fclose(f) != 0) {
+        free(buf);
+        return NULL;
+    }
+    *out_len = len;
+    return buf;
+}
+
+static inline int metrics_write_all(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(fd, buf, len);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        buf += w;
+        len -= w;
+    }
+    return 0;
+}
+
+// 연결 하나: 요청을 읽고 (HTTP GET 이면 헤더를 붙여서) 현재 값을 보내고 닫음
+static inline void metrics_reply(const MetricsPage* m, int c) {
+    char req[1024];
+    struct timeval tv = { 0, METRICS_POLL_MS * 1000 };
+    setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ssize_t n = read(c, req, sizeof(req) - 1);
+    req[n > 0 ? n : 0] = '\0';
+    size_t len;
+    char* body = metrics_format(m, &len);
+    if (!body) return;
+    if (strncmp(req, "GET ", 4) == 0) {
+        char head[160];
+        int hl = snprintf(head, sizeof(head), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                          "Content-Length: %zu\r\nConnection: close\r\n\r\n", len);
+        if (metrics_write_all(c, head, hl) < 0) {
+            free(body);
+            return;
+        }
+    }
+    metrics_write_all(c, body, len);
+    free(body);
+}
+
+static inline void* metrics_thread(void* arg) {
+    MetricsPage* m = arg;
+    struct pollfd pfd = { m->fd, POLLIN, 0 };
+    while (!__atomic_load_n(&m->stop, __ATOMIC_RELAXED)) {
+        if (poll(&pfd, 1, METRICS_POLL_MS) <= 0) continue;
+        int c = accept(m->fd, NULL, NULL);
+        if (c < 0) continue;
+        metrics_reply(m, c);
+        close(c);
+    }
+    return NULL;
+}
+
+// path 에 Unix 소켓을 열고 서버 스레드 시작, 실패하면 -1
+static inline int metrics_serve(MetricsPage* m, const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Metrics socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    strcpy(m->path, path);
+    m->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(path);  // 이전 실행이 남긴 소켓 파일
+    if (m->fd < 0 || bind(m->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(m->fd, 16) < 0) {
+        perror(path);
+        if (m->fd >= 0) close(m->fd);
+        m->fd = -1;
+        return -1;
+    }
+    m->stop = 0;
+    if (pthread_create(&m->tid, NULL, metrics_thread, m) != 0) {
+        fprintf(stderr, "Failed to start the metrics thread.\n");
+        close(m->fd);
+        unlink(path);
+        m->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+// 서버를 멈추고 소켓과 페이지 정리
+static inline void metrics_close(MetricsPage* m) {
+    if (m->fd >= 0) {
+        __atomic_store_n(&m->stop, 1, __ATOMIC_RELAXED);
+        pthread_join(m->tid, NULL);
+        close(m->fd);
+        unlink(m->path);
+        m->fd = -1;
+    }
+    if (m->hdr) munmap(m->hdr, m->len);
+    m->hdr = NULL;
+}
+
+#endif
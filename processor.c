@@ -7,26 +7,31 @@
 #include <sys/wait.h>
 #include <sys/resource.h>
 #include "result.h"
+#include "arena.h"
+#include "workload.h"
+#include "latch.h"
 
-#define TOTAL_FILES 60      	// 전체 가상 파일 개수
-#define MAX_TASKS 100       	// 큐에 넣을 수 있는 최대 작업 수
 #define TIME_MULTIPLIER 10000  // 알고리즘 시간 조절용 배수
-#define MAX_FILES_PER_PROC 60
+#define MAX_FILES_PER_PROC 60  // 분배 결과 로그에 나열할 프로세스당 최대 파일 수
 
 // 파일의 처리 단계 정의
 typedef enum { RAW, BWT_DONE, MTF_DONE } Stage;
 
-// 작업 구조체: 파일 이름, 데이터, 현재 단계 포함
+// 작업 구조체: 파일 이름, 입출력 버퍼, 현재 단계 포함
+// 단계마다 out 에 쓰고 in/out 포인터만 교체 (단계 간 복사 없음)
 typedef struct {
 	char* name;
-	char  data[256];
+	char* in;    // 현재 단계 입력
+	char* out;   // 현재 단계 출력
+	size_t cap;  // 버퍼 하나의 크기 (파일 크기에 비례)
 	Stage stage;
 	int size;  // 파일 크기
 } Task;
 
 typedef struct {
-	int indices[MAX_FILES_PER_PROC];
+	int* indices;  // 배정된 파일 인덱스 (realloc 으로 늘림)
 	int count;
+	int cap;
 	int total_size;
 } ProcessLoad;
 
@@ -37,7 +42,7 @@ typedef struct {
 } FileEntry;
 
 // 단계별 큐
-Task* raw_queue[MAX_TASKS], * bwt_queue[MAX_TASKS], * mtf_queue[MAX_TASKS];
+Task** raw_queue, ** bwt_queue, ** mtf_queue;  // 프로세스가 맡은 작업 수만큼 할당
 int raw_head = 0, raw_tail = 0;
 int bwt_head = 0, bwt_tail = 0;
 int mtf_head = 0, mtf_tail = 0;
@@ -46,22 +51,13 @@ int mtf_head = 0, mtf_tail = 0;
 pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
 
-int completed_tasks = 0;
-int task_target = 0;
+// 완료 추적: 남은 작업 수 래치 (latch.h)
+Latch tasks_left;
 
-// cpu 돌리는 시간
-pthread_mutex_t complete_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t all_done = PTHREAD_COND_INITIALIZER;
-
-// 파일 크기 배열 (1~100 범위의 임의 수)
-int file_sizes[TOTAL_FILES] = {
-	73, 18, 94, 26, 51, 62, 37, 89, 5, 43,
-	77, 14, 35, 68, 92, 10, 23, 81, 6, 57,
-	49, 87, 30, 1, 99, 64, 12, 46, 91, 28,
-	39, 83, 7, 58, 100, 22, 75, 33, 9, 67,
-	29, 56, 44, 15, 79, 2, 88, 11, 93, 16,
-	84, 31, 21, 60, 70, 4, 95, 36, 47, 8
-};
+// 작업 목록 (--workload, 기본은 60개 표)
+int total_files;
+int* file_sizes;
+int time_multiplier = TIME_MULTIPLIER;
 
 // 내림차순 정렬용 비교 함수
 int cmp_desc(const void* a, const void* b) {
@@ -70,20 +66,26 @@ int cmp_desc(const void* a, const void* b) {
 
 // Greedy 분배 함수
 void assign_files_greedy(int P, ProcessLoad buckets[P]) {
-	FileEntry files[TOTAL_FILES];
-	for (int i = 0; i < TOTAL_FILES; i++) {
+	FileEntry* files = malloc(sizeof(FileEntry) * total_files);
+	if (!files) {
+    	fprintf(stderr, "Failed to allocate %d file entries.\n", total_files);
+    	exit(1);
+	}
+	for (int i = 0; i < total_files; i++) {
     	files[i].index = i;
     	files[i].size = file_sizes[i];
 	}
 
-	qsort(files, TOTAL_FILES, sizeof(FileEntry), cmp_desc); // 내림차순 정렬
+	qsort(files, total_files, sizeof(FileEntry), cmp_desc); // 내림차순 정렬
 
 	for (int i = 0; i < P; i++) {
     	buckets[i].count = 0;
     	buckets[i].total_size = 0;
+    	buckets[i].cap = 0;
+    	buckets[i].indices = NULL;
 	}
 
-	for (int i = 0; i < TOTAL_FILES; i++) {
+	for (int i = 0; i < total_files; i++) {
     	// 가장 적은 작업량을 가진 프로세스 찾기
     	int min_idx = 0;
     	for (int j = 1; j < P; j++) {
@@ -93,21 +95,32 @@ void assign_files_greedy(int P, ProcessLoad buckets[P]) {
 
     	// 배정
     	int proc = min_idx;
+    	if (buckets[proc].count == buckets[proc].cap) {
+        	buckets[proc].cap = buckets[proc].cap ? buckets[proc].cap * 2 : 64;
+        	buckets[proc].indices = realloc(buckets[proc].indices, sizeof(int) * buckets[proc].cap);
+        	if (!buckets[proc].indices) {
+            	fprintf(stderr, "Failed to grow the file list of process %d.\n", proc);
+            	exit(1);
+        	}
+    	}
     	buckets[proc].indices[buckets[proc].count++] = files[i].index;
     	buckets[proc].total_size += files[i].size;
 	}
+	free(files);
 
 	// 로그 출력
 	printf("\n[파일 분배 결과 - Greedy 방식]\n");
 	for (int i = 0; i < P; i++) {
     	printf("프로세스 %d: 총 작업량 = %d (파일 %d개)\n ", i, buckets[i].total_size, buckets[i].count);
-    	for (int j = 0; j < buckets[i].count; j++) {
+    	for (int j = 0; j < buckets[i].count && j < MAX_FILES_PER_PROC; j++) {
         	int idx = buckets[i].indices[j];
         	printf("file_%02d(%d) ", idx, file_sizes[idx]);
        	 
         	if ((j+1) % 6 == 0)
             	printf("\n  ");
     	}
+    	if (buckets[i].count > MAX_FILES_PER_PROC)
+        	printf("... (%d more)", buckets[i].count - MAX_FILES_PER_PROC);
     	printf("\n");
 	}
 }
@@ -115,21 +128,21 @@ void assign_files_greedy(int P, ProcessLoad buckets[P]) {
 // CPU 부하 시뮬레이션 함수
 void run_cpu_for(int times) {
 	volatile double dummy = 0;
-	for (int i = 0; i < times * TIME_MULTIPLIER; i++) {
+	for (int i = 0; i < times * time_multiplier; i++) {
     	dummy += i * 0.000001;
 	}
 }
 
 // BWT 단계 (지연 포함)
-void apply_bwt(char* output, const char* input, int size) {
+void apply_bwt(char* output, size_t cap, const char* input, int size) {
 	run_cpu_for(5 * size);
-	snprintf(output, 256, "bwt(%s)", input);
+	snprintf(output, cap, "bwt(%s)", input);
 }
 
 // MTF 단계 (지연 포함)
-void apply_mtf(char* output, const char* input, int size) {
+void apply_mtf(char* output, size_t cap, const char* input, int size) {
 	run_cpu_for(3 * size);
-	snprintf(output, 256, "mtf(%s)", input);
+	snprintf(output, cap, "mtf(%s)", input);
 }
 
 // RLE + Huffman 단계 (지연 포함)
@@ -140,10 +153,10 @@ void apply_rle(const char* input, int size) {
 // ── Process-only 모드 전용: 동적할당·락 없이 순차 처리 ──
 void run_process_only(int P, int idx) {
 	char buf1[256], buf2[256];
-	for (int i = idx; i < TOTAL_FILES; i += P) {
+	for (int i = idx; i < total_files; i += P) {
     	int size = file_sizes[i];
-    	apply_bwt(buf1, "content", size);
-    	apply_mtf(buf2, buf1, size);
+    	apply_bwt(buf1, sizeof(buf1), "content", size);
+    	apply_mtf(buf2, sizeof(buf2), buf1, size);
     	apply_rle(buf2, size);
 	}
 }
@@ -154,8 +167,8 @@ void run_process_only_optimized(ProcessLoad* my_bucket) {
 	for (int i = 0; i < my_bucket->count; i++) {
     	int idx = my_bucket->indices[i];
     	int size = file_sizes[idx];
-    	apply_bwt(buf1, "content", size);
-    	apply_mtf(buf2, buf1, size);
+    	apply_bwt(buf1, sizeof(buf1), "content", size);
+    	apply_mtf(buf2, sizeof(buf2), buf1, size);
     	apply_rle(buf2, size);
 	}
 }
@@ -165,10 +178,10 @@ typedef struct { int id, T; } ThreadArg;
 void* thread_func_opt(void* _a) {
 	ThreadArg * a = _a;
 	char buf1[256], buf2[256];
-	for (int i = a->id; i < TOTAL_FILES; i += a->T) {
+	for (int i = a->id; i < total_files; i += a->T) {
     	int size = file_sizes[i];
-    	apply_bwt(buf1, "content", size);
-    	apply_mtf(buf2, buf1, size);
+    	apply_bwt(buf1, sizeof(buf1), "content", size);
+    	apply_mtf(buf2, sizeof(buf2), buf1, size);
     	apply_rle(buf2, size);
 	}
 	return NULL;
@@ -185,6 +198,13 @@ void run_thread_only(int T) {
     	pthread_join(th[t], NULL);
 }
 
+// 단계 출력을 다음 단계 입력으로 넘김 (포인터 교체)
+static inline void swap_buffers(Task* task) {
+	char* t = task->in;
+	task->in = task->out;
+	task->out = t;
+}
+
 // 작업 큐에 추가 (단계별 큐 사용)
 void enqueue_task(Task* task) {
 	pthread_mutex_lock(&queue_mutex);
@@ -227,25 +247,21 @@ void* worker_thread(void* arg) {
     	Task* task = dequeue_highest_priority_task();
     	switch (task->stage) {
     	case RAW:
-        	apply_bwt(task->data, task->data, task->size);
+        	apply_bwt(task->out, task->cap, task->in, task->size);
+        	swap_buffers(task);
         	task->stage = BWT_DONE;
         	enqueue_task(task);
         	break;
     	case BWT_DONE:
-        	apply_mtf(task->data, task->data, task->size);
+        	apply_mtf(task->out, task->cap, task->in, task->size);
+        	swap_buffers(task);
         	task->stage = MTF_DONE;
         	enqueue_task(task);
         	break;
     	case MTF_DONE:
-        	apply_rle(task->data, task->size);
-        	pthread_mutex_lock(&complete_mutex);
-        	completed_tasks++;
-        	if (completed_tasks == task_target) {
-            	pthread_cond_signal(&all_done);
-        	}
-        	pthread_mutex_unlock(&complete_mutex);
-        	free(task->name);
-        	free(task);
+        	apply_rle(task->in, task->size);
+        	free(task->name);  // Task 와 버퍼는 아레나 소유 (래치가 풀리면 해제되므로 먼저)
+        	latch_count_down(&tasks_left, 1);
         	break;
     	}
 	}
@@ -263,11 +279,36 @@ void run_compressor(int thread_count, int proc_index, int total_proc) {
     	pthread_create(&threads[i], NULL, worker_thread, NULL);
 	}
 	int count = 0;
-	for (int i = proc_index; i < TOTAL_FILES; i += total_proc) count++;
-	task_target = count;
-	for (int i = proc_index; i < TOTAL_FILES; i += total_proc) {
-    	Task* task = malloc(sizeof(Task));
-    	strncpy(task->data, "content", sizeof(task->data));
+	size_t arena_bytes = 0;
+	for (int i = proc_index; i < total_files; i += total_proc) {
+    	count++;
+    	arena_bytes += arena_size(sizeof(Task)) + 2 * arena_size(TASK_BUF_BYTES(file_sizes[i]));
+	}
+	latch_init(&tasks_left, count);
+
+	// 단계별 큐: 작업마다 단계당 한 번씩만 들어가므로 작업 수만큼이면 충분
+	Task** queues = malloc(sizeof(Task*) * count * 3);
+	if (!queues) {
+    	fprintf(stderr, "Failed to allocate queues for %d tasks.\n", count);
+    	return;
+	}
+	raw_queue = queues;
+	bwt_queue = queues + count;
+	mtf_queue = queues + 2 * count;
+
+	// 이 프로세스가 맡은 작업의 Task 와 버퍼를 한 번에 할당
+	Arena arena;
+	if (arena_init(&arena, arena_bytes) < 0) {
+    	fprintf(stderr, "Failed to allocate %zu bytes of task buffers.\n", arena_bytes);
+    	free(queues);
+    	return;
+	}
+	for (int i = proc_index; i < total_files; i += total_proc) {
+    	Task* task = arena_alloc(&arena, sizeof(Task));
+    	task->cap = TASK_BUF_BYTES(file_sizes[i]);
+    	task->in = arena_alloc(&arena, task->cap);
+    	task->out = arena_alloc(&arena, task->cap);
+    	snprintf(task->in, task->cap, "content");
     	char name[32];
     	snprintf(name, sizeof(name), "file_%02d", i);
     	task->name = strdup(name);
@@ -275,30 +316,36 @@ void run_compressor(int thread_count, int proc_index, int total_proc) {
     	task->size = file_sizes[i];
     	enqueue_task(task);
 	}
-	pthread_mutex_lock(&complete_mutex);
-	while (completed_tasks < task_target)
-    	pthread_cond_wait(&all_done, &complete_mutex);
-	pthread_mutex_unlock(&complete_mutex);
+	latch_wait(&tasks_left);
+	arena_destroy(&arena);
+	free(queues);
 }
 
 // 메인 함수: 전체 프로세스를 생성하고 성능 측정
 int main(int argc, char* argv[]) {
+	Workload workload;
+	if (workload_args(&argc, &argv, &workload) < 0) return 1;
 	if (argc != 3) {
-    	fprintf(stderr, "Usage: %s <process_count> <thread_count>\n", argv[0]);
+    	fprintf(stderr, "Usage: %s [--workload spec] <process_count> <thread_count>\n", argv[0]);
     	return 1;
 	}
 	int P = atoi(argv[1]);	// 자식 프로세스 수
 	int T = atoi(argv[2]);	// 워커 스레드 수
+	total_files = workload.count;
+	file_sizes = workload.sizes;
+	if (workload.time_multiplier > 0) time_multiplier = workload.time_multiplier;
+	if (workload.bytes_per_unit > 0) bytes_per_unit = workload.bytes_per_unit;
+	workload_describe(&workload, stdout);
 	PerfMetrics metrics;
 
 	// ──── 1) 순차(single) 모드 (C0) ───────────────────────────────
 	if (P == 0 && T == 0) {
     	start_perf(&metrics);
     	char buf1[256], buf2[256];
-    	for (int i = 0; i < TOTAL_FILES; i++) {
+    	for (int i = 0; i < total_files; i++) {
         	int size = file_sizes[i];
-        	apply_bwt(buf1, "content", size);
-        	apply_mtf(buf2, buf1, size);
+        	apply_bwt(buf1, sizeof(buf1), "content", size);
+        	apply_mtf(buf2, sizeof(buf2), buf1, size);
         	apply_rle(buf2, size);
     	}
     	end_perf(&metrics, 0);
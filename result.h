@@ -9,12 +9,22 @@
 #include <errno.h>
 #include <unistd.h>
 #include <math.h>
+#include "lockstat.h"
 
 // 시간 및 자원 사용량 측정용 구조체 정의
 typedef struct {
     struct timeval start_time;
     struct timeval end_time;
     struct rusage usage;  // 누적 자원 (child 또는 self)
+    double makespan_ms;         // 마지막 작업 완료 시각 (큐를 쓰는 모드만, 0 이면 출력 생략)
+    double mean_completion_ms;  // 작업별 완료 시각의 평균
+    long lock_acquisitions;     // 큐/완료 뮤텍스 획득 횟수 (큐를 쓰는 모드만)
+    long long bytes_processed;  // 처리한 작업 버퍼 바이트
+    long dequeues;              // 큐에서 꺼낸 횟수와 그때 꺼낸 작업 수
+    long dequeued_tasks;
+    LockStat locks[LOCKSTAT_MAX_SITES];  // 잠금 호출 위치별 경합 (-DLOCKSTAT 일 때만 채워짐)
+    const char* const* lock_sites;       // 위치 이름 (NULL 이면 출력 생략)
+    int lock_site_count;
 } PerfMetrics;
 
 // 시간 정규화 함수
@@ -29,6 +39,14 @@ static inline void normalize_time(struct timeval* t) {
 static inline void start_perf(PerfMetrics* m) {
     gettimeofday(&m->start_time, NULL);
     memset(&m->usage, 0, sizeof(struct rusage));
+    m->makespan_ms = 0.0;
+    m->mean_completion_ms = 0.0;
+    m->lock_acquisitions = 0;
+    m->bytes_processed = 0;
+    m->dequeues = m->dequeued_tasks = 0;
+    memset(m->locks, 0, sizeof(m->locks));
+    m->lock_sites = NULL;
+    m->lock_site_count = 0;
 }
 
 // 측정 종료: 자식 or self 자원 수집
@@ -78,8 +96,8 @@ static inline void end_perf(PerfMetrics* m, int child_count) {
     gettimeofday(&m->end_time, NULL);
 }
 
-// 출력 함수
-static inline void print_perf_summary(const PerfMetrics* m) {
+// 출력 함수 (stdout 을 데이터로 쓰는 모드는 stderr 로 출력)
+static inline void fprint_perf_summary(FILE* out, const PerfMetrics* m) {
     double wall = (m->end_time.tv_sec - m->start_time.tv_sec) * 1000.0 +
         (m->end_time.tv_usec - m->start_time.tv_usec) / 1000.0;
 
@@ -97,15 +115,30 @@ static inline void print_perf_summary(const PerfMetrics* m) {
 
     double cpu_idle_percent = (wall > 0.0) ? fmax(0.0, 100.0 * (1.0 - (cpu_total / wall))) : 0.0;
 
-    printf("\nTotal compression time: %.3f ms\n", wall);
-    printf("CPU User time (all):    %.3f ms\n", user);
-    printf("CPU System time (all):  %.3f ms\n", sys);
-    printf("Max Memory Usage:       %ld KB\n", mem_kb);
-    printf("Voluntary Ctx Switches:   %ld\n", vctx);
-    printf("Involuntary Ctx Switches: %ld\n", ivctx);
-    printf("Total Context Switches:   %ld\n", vctx + ivctx);
-    printf("\nCPU Idle Percent:       %.2f %%\n", cpu_idle_percent);
-    printf("Avg CPU Core Usage:     %.2f %%\n", avg_core_util_percent);
+    fprintf(out, "\nTotal compression time: %.3f ms\n", wall);
+    fprintf(out, "CPU User time (all):    %.3f ms\n", user);
+    fprintf(out, "CPU System time (all):  %.3f ms\n", sys);
+    fprintf(out, "Max Memory Usage:       %ld KB\n", mem_kb);
+    fprintf(out, "Voluntary Ctx Switches:   %ld\n", vctx);
+    fprintf(out, "Involuntary Ctx Switches: %ld\n", ivctx);
+    fprintf(out, "Total Context Switches:   %ld\n", vctx + ivctx);
+    if (LOCKSTAT_ENABLED && m->lock_sites)
+        lockstat_print(out, m->locks, m->lock_sites, m->lock_site_count);
+    fprintf(out, "\nCPU Idle Percent:       %.2f %%\n", cpu_idle_percent);
+    fprintf(out, "Avg CPU Core Usage:     %.2f %%\n", avg_core_util_percent);
+    if (m->makespan_ms > 0.0) {
+        fprintf(out, "\nMakespan:               %.3f ms\n", m->makespan_ms);
+        fprintf(out, "Mean completion time:   %.3f ms\n", m->mean_completion_ms);
+    }
+    if (m->lock_acquisitions > 0) {
+        fprintf(out, "\nLock acquisitions:      %ld (%.4f per KB)\n", m->lock_acquisitions,
+            m->bytes_processed > 0 ? m->lock_acquisitions * 1024.0 / m->bytes_processed : 0.0);
+        fprintf(out, "Tasks per dequeue:      %.2f\n", m->dequeues > 0 ? (double)m->dequeued_tasks / m->dequeues : 0.0);
+    }
+}
+
+static inline void print_perf_summary(const PerfMetrics* m) {
+    fprint_perf_summary(stdout, m);
 }
 
 #endif
@@ -6,68 +6,225 @@
 #include <sys/time.h>
 #include <sys/wait.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <spawn.h>
 #include "result.h"
+#include "arena.h"
+#include "taskq.h"
+#include "workload.h"
+#include "latch.h"
+#include "metrics.h"
+#include "lockstat.h"
 
-#define TOTAL_FILES 60          // 전체 가상 파일 개수
-#define MAX_TASKS 100           // 큐에 넣을 수 있는 최대 작업 수
 #define TIME_MULTIPLIER 10000  // 알고리즘 시간 조절용 배수
+#define AGING_RATE 5           // aging 정책: 나중에 들어온 작업 하나당 더해지는 비용
+#define BWT_WORKSET_FACTOR 8   // BWT 작업 메모리 (접미사 배열 등): 작업 버퍼 크기의 배수
+#define BUDGET_POLL_MS 1       // 다른 프로세스의 메모리 반납을 다시 확인하는 주기
+#define OUTPUT_RATIO 4         // 가상 압축 결과 크기: 작업 버퍼의 1/4
+#define OUT_MAGIC "PFCOUT1"
+#define JOURNAL_MAGIC 0x4a434650u  // "PFCJ"
+#define JOURNAL_CHECKPOINT_MS 50       // 체크포인트 스레드가 모인 완료를 디스크에 내리는 주기
+#define JOURNAL_CHECKPOINT_RECORDS 64  // 이만큼 모이면 주기를 기다리지 않고 바로
+#define MAX_BATCH 64               // --batch 상한 (워커 스택의 배치 배열 크기)
 
 // 파일의 처리 단계 정의
 typedef enum { RAW, BWT_DONE, MTF_DONE } Stage;
 
-// 작업 구조체: 파일 이름, 데이터, 현재 단계 포함
+// 작업 구조체: 파일 이름, 입출력 버퍼, 현재 단계 포함
+// 단계마다 out 에 쓰고 in/out 포인터만 교체 (단계 간 복사 없음)
 typedef struct {
     char* name;
-    char  data[256];
+    char* in;    // 현재 단계 입력
+    char* out;   // 현재 단계 출력
+    size_t cap;  // 버퍼 하나의 크기 (파일 크기에 비례)
     Stage stage;
     int size;  // 파일 크기
+    int file;  // file_sizes 인덱스 (출력 인덱스 위치)
+    int* files;  // 이 작업이 담은 파일들 (보통은 &file 하나, solid 블록이면 여러 개)
+    int nfiles;
+    Latch* latch;  // 완료를 알릴 래치 (보통은 tasks_left, pool 모드에서는 청크별)
 } Task;
 
-// 단계별 큐
-Task* raw_queue[MAX_TASKS], * bwt_queue[MAX_TASKS], * mtf_queue[MAX_TASKS];
-int raw_head = 0, raw_tail = 0;
-int bwt_head = 0, bwt_tail = 0;
-int mtf_head = 0, mtf_tail = 0;
+// 스케줄링 정책: 작업과 넣는 순서로 힙 key 를 계산 (작을수록 먼저)
+typedef long (*policy_key_fn)(const Task* task, long seq);
+
+typedef struct {
+    const char* name;
+    policy_key_fn key;
+} Policy;
+
+// 단계별 남은 처리 비용 (apply_bwt/mtf/rle 의 배수 5, 3, 2 의 합)
+static const int remaining_cost[] = { 10, 5, 2 };
+
+static long remaining_work(const Task* task) {
+    return (long)remaining_cost[task->stage] * task->size;
+}
+
+// stage: 기존 방식 (MTF > BWT > RAW, 단계 안에서는 FIFO)
+long key_stage(const Task* task, long seq) { return -(long)task->stage; }
+// fifo: 단계와 무관하게 넣은 순서대로
+long key_fifo(const Task* task, long seq) { return 0; }
+// sjf: 남은 처리량이 가장 적은 작업부터 (평균 완료 시간 최소화)
+long key_sjf(const Task* task, long seq) { return remaining_work(task); }
+// lpt: 남은 처리량이 가장 많은 작업부터 (makespan 최소화)
+long key_lpt(const Task* task, long seq) { return -remaining_work(task); }
+// aging: sjf 에 대기 시간을 더해서 큰 작업이 굶지 않게
+// (나중에 들어온 작업일수록 key 가 커지므로 오래 기다린 작업이 결국 앞섬)
+long key_aging(const Task* task, long seq) { return remaining_work(task) + seq * AGING_RATE; }
+
+Policy policies[] = {
+    { "stage", key_stage },
+    { "fifo", key_fifo },
+    { "sjf", key_sjf },
+    { "lpt", key_lpt },
+    { "aging", key_aging },
+};
+#define POLICY_COUNT (int)(sizeof(policies) / sizeof(policies[0]))
+
+const Policy* policy = &policies[0];
+
+// 대기열 (정책 key 순 힙, 모든 단계 공용, 크기는 프로세스가 맡은 작업 수)
+TaskQ ready_queue;
+
+// 메모리 예산 (--mem-budget, hybrid 모드): 모든 프로세스가 공유 메모리의 한 카운터를 나눠 씀
+// 예산이 있으면 RAW 작업은 admission 대기열(작은 작업 먼저)에 두었다가
+// 추정 작업 메모리가 예산에 들어갈 때만 꺼냄
+typedef struct {
+    pthread_mutex_t lock;  // PTHREAD_PROCESS_SHARED
+    long long limit;
+    long long used;
+    long long peak;
+    long deferred;  // 예산 부족으로 admission 이 실패한 횟수 (재시도 포함)
+} MemBudget;
+
+long long mem_budget_limit = 0;  // 0 이면 제한 없음
+MemBudget* mem_budget = NULL;
+TaskQ pending_queue;
 
 // 동기화 변수
 pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
 
-int completed_tasks = 0;
-int task_target = 0;
-
-// cpu 돌리는 시간
-pthread_mutex_t complete_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t all_done = PTHREAD_COND_INITIALIZER;
-
-// 파일 크기 배열 (1~100 범위의 임의 수)
-int file_sizes[TOTAL_FILES] = {
-    73, 18, 94, 26, 51, 62, 37, 89, 5, 43,
-    77, 14, 35, 68, 92, 10, 23, 81, 6, 57,
-    49, 87, 30, 1, 99, 64, 12, 46, 91, 28,
-    39, 83, 7, 58, 100, 22, 75, 33, 9, 67,
-    29, 56, 44, 15, 79, 2, 88, 11, 93, 16,
-    84, 31, 21, 60, 70, 4, 95, 36, 47, 8
+// 잠금 경합 프로파일 (-DLOCKSTAT): 호출 위치별 칸, 이 프로세스 몫
+enum { LOCK_ENQUEUE, LOCK_DEQUEUE, LOCK_ADMISSION, LOCK_COMPLETION, LOCK_SITES };
+const char* const lock_site_names[LOCK_SITES] = {
+    "queue_mutex/enqueue", "queue_mutex/dequeue", "mem_budget/admission", "mem_budget/completion"
 };
+LockStat lock_stats[LOCK_SITES];
+
+// 완료 추적: 워커별 완료 통계 + 남은 작업 수 래치 (latch.h)
+Latch tasks_left;
+WorkerCounter* worker_done = NULL;  // 스레드 수만큼
+
+int time_multiplier = TIME_MULTIPLIER;  // 자동 튜닝의 보정 실행에서 축소
+
+// 작업 완료 시각 통계 (hybrid 모드): 프로세스별 칸을 공유 메모리에 두고 부모가 합산
+typedef struct {
+    long count;
+    double sum_ms;  // 실행 시작부터 각 작업 완료까지의 시간 합
+    double max_ms;  // 마지막 작업 완료 시각
+    long locks;             // 뮤텍스 획득 횟수
+    long long bytes;        // 처리한 작업 버퍼 바이트
+    long dequeues;
+    long dequeued;
+    LockStat lock_stats[LOCK_SITES];
+} CompletionStats;
+
+// 배치 (--batch K, --batch-units N, --solid N, hybrid 모드)
+//   한 번 큐 잠금을 잡을 때 최대 K 개 (또는 합계 N 크기 단위까지) 작업을 꺼내 이어서 처리하고,
+//   다음 단계로 넘길 작업과 완료 보고도 배치 단위로 한 번에 잠금을 잡아서 처리
+//   크기가 N 미만인 파일은 합계가 N 이 될 때까지 하나의 solid 작업으로 묶음
+int batch_max = 1;
+int batch_units = 0;  // 0 이면 크기 제한 없음
+int solid_units = 0;  // 0 이면 묶지 않음
+long lock_count = 0;      // 이 프로세스의 queue_mutex 획득 횟수 (atomic)
+long dequeue_count = 0;   // 꺼낸 횟수 / 꺼낸 작업 수 (queue_mutex 안에서 갱신)
+long dequeued_tasks = 0;
+
+CompletionStats* completion_stats = NULL;  // 프로세스 수만큼, 공유 매핑
+CompletionStats* my_completion = NULL;     // 이 프로세스의 칸
+struct timeval run_start;
+
+// 실행 중 지표 (--metrics <socket>, metrics.h): 부모가 공유 페이지와 서버 스레드를 만들고
+// 각 프로세스는 자기 칸(proc_metrics)과 워커 칸(my_workers[워커 번호])에만 기록
+const char* metrics_path = NULL;
+MetricsPage metrics_page;
+ProcMetrics* proc_metrics = NULL;
+WorkerMetrics* my_workers = NULL;
+static const char* const stage_names[METRICS_STAGES] = { "bwt", "mtf", "rle" };
+
+// 작업 목록 (--workload, 기본은 60개 표)
+Workload workload;
+int total_files;
+int* file_sizes;
+
+// 공유 출력 파일 (--out): 부모가 fallocate 로 전체 크기를 잡고 MAP_SHARED 로 매핑,
+// 자식 프로세스/스레드는 헤더의 bump 포인터를 atomic 으로 올려 자리를 예약하고 제자리에 기록
+typedef struct {
+    uint64_t off;
+    uint32_t len;
+    uint32_t done;
+} OutIndexEntry;
+
+typedef struct {
+    char magic[8];
+    uint64_t next_off;    // 다음 기록 위치 (atomic fetch-add 로 예약)
+    uint64_t data_start;
+    uint64_t data_end;    // 마무리할 때 기록
+    uint32_t file_count;
+    uint32_t finalized;   // 1 이면 인덱스가 완성된 파일
+    OutIndexEntry index[];  // file_count 개
+} OutHeader;
+
+const char* out_path = NULL;
+int out_fd = -1;
+OutHeader* out_map = NULL;
+size_t out_map_len = 0;
+
+// 체크포인트 저널 (<out>.journal): 결과가 기록된 파일마다 한 줄씩 O_APPEND 로 추가
+// --resume 이면 저널에 있는 파일은 건너뛰고 나머지만 다시 처리
+// 워커는 인덱스 칸만 채우고 완료를 목록에 올림. 프로세스마다 체크포인트 스레드 하나가
+// 주기적으로 모인 완료의 결과를 msync 한 뒤 저널에 한 번에 추가하고 fdatasync
+typedef struct {
+    uint32_t magic;
+    uint32_t file;
+    uint64_t off;
+    uint32_t len;
+    uint32_t check;  // 찢어진 기록 검출용
+} JournalRecord;
+
+int resume = 0;
+int journal_fd = -1;
+char journal_path[4096];
+pthread_mutex_t journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t journal_wake = PTHREAD_COND_INITIALIZER;
+JournalRecord* journal_pending = NULL;  // 아직 저널에 없는 완료 (체크포인트 스레드가 통째로 가져감)
+int journal_pending_len = 0, journal_pending_cap = 0;
+int journal_stopping = 0;
+int journal_running = 0;  // 이 프로세스의 체크포인트 스레드가 떠 있는지
+pthread_t journal_tid;
 
 // CPU 부하 시뮬레이션 함수
 void run_cpu_for(int times) {
     volatile double dummy = 1.0;
-    for (int i = 0; i < times * TIME_MULTIPLIER; i++) {
+    for (int i = 0; i < times * time_multiplier; i++) {
         dummy += i * 1.000001;
     }
 }
 
 // BWT 단계 (지연 포함)
-void apply_bwt(char* output, const char* input, int size) {
+void apply_bwt(char* output, size_t cap, const char* input, int size) {
     run_cpu_for(5 * size);
-    snprintf(output, 256, "bwt(%s)", input);
+    snprintf(output, cap, "bwt(%s)", input);
 }
 
 // MTF 단계 (지연 포함)
-void apply_mtf(char* output, const char* input, int size) {
+void apply_mtf(char* output, size_t cap, const char* input, int size) {
     run_cpu_for(3 * size);
-    snprintf(output, 256, "mtf(%s)", input);
+    snprintf(output, cap, "mtf(%s)", input);
 }
 
 // RLE + Huffman 단계 (지연 포함)
@@ -75,15 +232,314 @@ void apply_rle(const char* input, int size) {
     run_cpu_for(2 * size);
 }
 
+// 파일 하나의 가상 압축 결과 크기
+static size_t compressed_size(int size) {
+    return TASK_BUF_BYTES(size) / OUTPUT_RATIO;
+}
+
+// 이 프로세스가 쓸 지표 칸을 정함 (fork 한 자식에서, 또는 부모가 직접 처리하는 모드에서)
+static void metrics_bind(int proc) {
+    if (!metrics_page.hdr) return;
+    proc_metrics = &metrics_page.proc[proc];
+    my_workers = metrics_worker(&metrics_page, proc, 0);
+}
+
+// 큐 없이 세 단계를 이어서 처리하는 모드: 파일 하나가 끝날 때 한 번에 기록
+static void metrics_file_done(WorkerMetrics* wm, int size, long long start_ns) {
+    for (int s = 0; s < METRICS_STAGES; s++)
+        metrics_add(&wm->done[s], 1);
+    metrics_add_ll(&wm->bytes_in, TASK_BUF_BYTES(size));
+    metrics_add_ll(&wm->bytes_out, compressed_size(size));
+    metrics_add_ll(&wm->busy_ns, metrics_now_ns() - start_ns);
+}
+
+static uint32_t journal_check(const JournalRecord* r) {
+    uint64_t h = ((uint64_t)r->magic << 32 | r->file) * 0x9e3779b97f4a7c15ULL;
+    h ^= (r->off + ((uint64_t)r->len << 40)) * 0xc2b2ae3d27d4eb4fULL;
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+// 이전 실행의 출력과 저널을 읽어서 끝난 파일의 인덱스 항목을 다시 만들고, 마지막 일관된 위치를 반환
+// (저널에 남은 기록 중 가장 뒤의 끝. 그 뒤의 내용은 버리고 이어서 기록)
+// 헤더의 인덱스는 마무리할 때만 msync 하므로 믿지 않음: 전원이 나가면 저널에 있는 파일도 비어 있을 수 있음
+uint64_t load_checkpoint(const OutHeader* old, size_t data_start, off_t file_len, OutIndexEntry* done, int* done_count) {
+    uint64_t consistent = data_start;
+    *done_count = 0;
+    if (memcmp(old->magic, OUT_MAGIC, sizeof(old->magic)) != 0 || old->file_count != (uint32_t)total_files ||
+        old->data_start != data_start)
+        return consistent;
+    int fd = open(journal_path, O_RDONLY);
+    if (fd < 0) return consistent;
+    JournalRecord r;
+    while (read(fd, &r, sizeof(r)) == (ssize_t)sizeof(r)) {
+        if (r.magic != JOURNAL_MAGIC || r.check != journal_check(&r) || r.file >= (uint32_t)total_files ||
+            r.len != compressed_size(file_sizes[r.file]) || r.off < data_start || r.off + r.len > (uint64_t)file_len)
+            break;  // 찢어진 꼬리 이후는 무시
+        if (!done[r.file].done) (*done_count)++;
+        done[r.file] = (OutIndexEntry){ r.off, r.len, 1 };
+        if (r.off + r.len > consistent) consistent = r.off + r.len;
+    }
+    close(fd);
+    return consistent;
+}
+
+// 출력 파일 준비: 헤더 + 모든 파일의 결과를 담을 크기를 미리 할당하고 매핑
+// --resume 이면 저널에 있는 파일의 결과는 그대로 두고 인덱스는 저널로 다시 채운 뒤 그 뒤부터 이어서 기록
+int out_open(const char* path) {
+    size_t header_len = sizeof(OutHeader) + sizeof(OutIndexEntry) * total_files;
+    size_t data_start = (header_len + 4095) & ~(size_t)4095;
+    snprintf(journal_path, sizeof(journal_path), "%s.journal", path);
+
+    out_fd = open(path, O_RDWR | O_CREAT | (resume ? 0 : O_TRUNC), 0644);
+    if (out_fd < 0) {
+        perror(path);
+        return -1;
+    }
+    OutHeader old;
+    OutIndexEntry* done = calloc(total_files, sizeof(OutIndexEntry));
+    if (!done) {
+        fprintf(stderr, "Failed to allocate the resume index.\n");
+        close(out_fd);
+        return -1;
+    }
+    int done_count = 0;
+    uint64_t start = data_start;
+    struct stat st;
+    if (resume && fstat(out_fd, &st) == 0 && pread(out_fd, &old, sizeof(old), 0) == (ssize_t)sizeof(old)) {
+        if (old.finalized && memcmp(old.magic, OUT_MAGIC, sizeof(old.magic)) == 0) {
+            fprintf(stderr, "%s is already complete.\n", path);
+            free(done);
+            close(out_fd);
+            out_fd = -1;
+            return -1;
+        }
+        start = load_checkpoint(&old, data_start, st.st_size, done, &done_count);
+    }
+
+    // 마지막 일관된 위치에서 자르고 남은 파일들의 크기만큼 다시 할당
+    size_t total = start;
+    for (int i = 0; i < total_files; i++)
+        if (!done[i].done) total += compressed_size(file_sizes[i]);
+    if (ftruncate(out_fd, start) < 0) {
+        perror("ftruncate failed");
+        free(done);
+        close(out_fd);
+        return -1;
+    }
+    int err = posix_fallocate(out_fd, 0, total);
+    if (err != 0) {
+        fprintf(stderr, "fallocate failed: %s\n", strerror(err));
+        free(done);
+        close(out_fd);
+        return -1;
+    }
+    out_map = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+    if (out_map == MAP_FAILED) {
+        perror("mmap failed");
+        out_map = NULL;
+        free(done);
+        close(out_fd);
+        return -1;
+    }
+    out_map_len = total;
+    memcpy(out_map->magic, OUT_MAGIC, sizeof(out_map->magic));
+    out_map->next_off = start;
+    out_map->data_start = data_start;
+    out_map->data_end = 0;
+    out_map->file_count = total_files;
+    out_map->finalized = 0;
+    memcpy(out_map->index, done, sizeof(OutIndexEntry) * total_files);
+    free(done);
+
+    journal_fd = open(journal_path, O_WRONLY | O_CREAT | O_APPEND | (done_count ? 0 : O_TRUNC), 0644);
+    if (journal_fd < 0) {
+        perror(journal_path);
+        return -1;
+    }
+    if (resume)
+        printf("[resume] %d of %d files already written, continuing at byte %llu\n",
+            done_count, total_files, (unsigned long long)start);
+    fflush(stdout);  // 자식이 버퍼를 중복 출력하지 않도록
+    return 0;
+}
+
+// 이미 결과가 기록된 파일인지 (--resume 에서 건너뛸 작업)
+static int file_done(int file) {
+    return out_map && out_map->index[file].done;
+}
+
+static int cmp_journal_off(const void* a, const void* b) {
+    const JournalRecord* x = a, * y = b;
+    return x->off < y->off ? -1 : x->off > y->off;
+}
+
+// 모인 완료를 디스크에 내린 뒤 저널에 추가 (저널에 있으면 재시작해도 다시 하지 않음)
+// 결과 구간은 위치순으로 정렬해서 이어지는 페이지끼리 msync 한 번으로 묶음
+static void journal_flush(JournalRecord* batch, int n) {
+    if (n == 0) return;
+    long page = sysconf(_SC_PAGESIZE);
+    qsort(batch, n, sizeof(JournalRecord), cmp_journal_off);
+    for (int i = 0; i < n; ) {
+        uint64_t start = batch[i].off & ~(uint64_t)(page - 1), end = batch[i].off + batch[i].len;
+        for (i++; i < n && (batch[i].off & ~(uint64_t)(page - 1)) <= end; i++)
+            if (batch[i].off + batch[i].len > end) end = batch[i].off + batch[i].len;
+        if (msync((char*)out_map + start, end - start, MS_SYNC) < 0) perror("msync failed");
+    }
+    for (int i = 0; i < n; i++)
+        batch[i].check = journal_check(&batch[i]);
+    if (write(journal_fd, batch, sizeof(JournalRecord) * n) != (ssize_t)(sizeof(JournalRecord) * n))
+        perror("journal write failed");
+    fdatasync(journal_fd);
+}
+
+// 완료를 목록에 올림 (워커 쪽, 디스크 작업 없음)
+static void journal_push(int file, uint64_t off, uint32_t len) {
+    pthread_mutex_lock(&journal_mutex);
+    if (journal_pending_len == journal_pending_cap) {
+        int cap = journal_pending_cap ? journal_pending_cap * 2 : JOURNAL_CHECKPOINT_RECORDS;
+        JournalRecord* p = realloc(journal_pending, sizeof(JournalRecord) * cap);
+        if (!p) {
+            fprintf(stderr, "Failed to allocate the journal queue.\n");
+            exit(1);
+        }
+        journal_pending = p;
+        journal_pending_cap = cap;
+    }
+    journal_pending[journal_pending_len++] = (JournalRecord){ JOURNAL_MAGIC, (uint32_t)file, off, len, 0 };
+    if (journal_pending_len == JOURNAL_CHECKPOINT_RECORDS) pthread_cond_signal(&journal_wake);
+    pthread_mutex_unlock(&journal_mutex);
+}
+
+// 목록을 통째로 가져감 (journal_mutex 를 잡고 호출)
+static JournalRecord* journal_take(int* n) {
+    JournalRecord* batch = journal_pending;
+    *n = journal_pending_len;
+    journal_pending = NULL;
+    journal_pending_len = journal_pending_cap = 0;
+    return batch;
+}
+
+// 체크포인트 스레드: 주기마다 (또는 많이 모이면 바로) 모인 완료를 내림, 멈출 때는 남은 것까지
+static void* journal_thread(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&journal_mutex);
+    while (1) {
+        if (!journal_stopping && journal_pending_len < JOURNAL_CHECKPOINT_RECORDS) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += JOURNAL_CHECKPOINT_MS * 1000000L;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&journal_wake, &journal_mutex, &ts);
+        }
+        int stop = journal_stopping, n;
+        JournalRecord* batch = journal_take(&n);
+        pthread_mutex_unlock(&journal_mutex);
+        journal_flush(batch, n);
+        free(batch);
+        if (stop) return NULL;
+        pthread_mutex_lock(&journal_mutex);
+    }
+}
+
+// 결과를 기록하는 프로세스마다 처리 전에 시작하고 끝난 뒤 멈춤 (--out 이 없으면 아무것도 안 함)
+static void journal_start() {
+    if (!out_map || journal_running) return;
+    journal_stopping = 0;
+    if (pthread_create(&journal_tid, NULL, journal_thread, NULL) != 0) {
+        fprintf(stderr, "Failed to start the checkpoint thread.\n");
+        exit(1);
+    }
+    journal_running = 1;
+}
+
+static void journal_stop() {
+    if (!out_map) return;
+    if (journal_running) {
+        pthread_mutex_lock(&journal_mutex);
+        journal_stopping = 1;
+        pthread_cond_signal(&journal_wake);
+        pthread_mutex_unlock(&journal_mutex);
+        pthread_join(journal_tid, NULL);
+        journal_running = 0;
+    }
+    int n;
+    pthread_mutex_lock(&journal_mutex);
+    JournalRecord* batch = journal_take(&n);
+    pthread_mutex_unlock(&journal_mutex);
+    journal_flush(batch, n);
+    free(batch);
+}
+
+// 파일 하나의 결과를 예약한 자리에 바로 기록하고 인덱스 항목을 채움
+void emit_output(int file, const char* data) {
+    if (!out_map) return;
+    size_t len = compressed_size(file_sizes[file]);
+    uint64_t off = __atomic_fetch_add(&out_map->next_off, len, __ATOMIC_RELAXED);
+    if (off + len > out_map_len) {
+        fprintf(stderr, "Output file overflow (file %d).\n", file);
+        exit(1);
+    }
+    char* dst = (char*)out_map + off;
+    size_t n = strnlen(data, len);
+    memcpy(dst, data, n);
+    memset(dst + n, 0, len - n);
+    out_map->index[file].off = off;
+    out_map->index[file].len = len;
+    __atomic_store_n(&out_map->index[file].done, 1, __ATOMIC_RELEASE);
+    journal_push(file, off, len);
+}
+
+// 모든 자식이 끝난 뒤 부모가 인덱스를 확인하고 마무리 (실제 끝까지 잘라냄)
+int out_finalize() {
+    int missing = 0;
+    for (int i = 0; i < total_files; i++)
+        if (!__atomic_load_n(&out_map->index[i].done, __ATOMIC_ACQUIRE)) missing++;
+    uint64_t end = out_map->next_off;
+    out_map->data_end = end;
+    out_map->finalized = missing == 0;
+    int rc = 0;
+    if (msync(out_map, out_map_len, MS_SYNC) < 0) {
+        perror("msync failed");
+        rc = -1;
+    }
+    munmap(out_map, out_map_len);
+    out_map = NULL;
+    if (ftruncate(out_fd, end) < 0) {
+        perror("ftruncate failed");
+        rc = -1;
+    }
+    close(out_fd);
+    out_fd = -1;
+    close(journal_fd);
+    journal_fd = -1;
+    if (missing) {
+        fprintf(stderr, "Output index incomplete: %d of %d files missing (rerun with --resume).\n", missing, total_files);
+        return -1;
+    }
+    unlink(journal_path);  // 인덱스가 완성되면 저널은 필요 없음
+    printf("[out] %d files, %llu bytes -> %s\n", total_files, (unsigned long long)end, out_path);
+    return rc;
+}
+
 // ── Process-only 모드 전용: 동적할당·락 없이 순차 처리 ──
 void run_process_only(int P, int idx) {
     char buf1[256], buf2[256];
-    for (int i = idx; i < TOTAL_FILES; i += P) {
+    metrics_bind(idx);
+    journal_start();
+    for (int i = idx; i < total_files; i += P) {
+        if (file_done(i)) continue;
+        long long t0 = my_workers ? metrics_now_ns() : 0;
         int size = file_sizes[i];
-        apply_bwt(buf1, "content", size);
-        apply_mtf(buf2, buf1, size);
+        apply_bwt(buf1, sizeof(buf1), "content", size);
+        apply_mtf(buf2, sizeof(buf2), buf1, size);
         apply_rle(buf2, size);
+        emit_output(i, buf2);
+        if (my_workers) metrics_file_done(&my_workers[0], size, t0);
     }
+    journal_stop();
 }
 
 // ── Thread-only 모드 전용: 뮤텍스 없이 인덱스 분할 ──
@@ -91,11 +547,15 @@ typedef struct { int id, T; } ThreadArg;
 void* thread_func_opt(void* _a) {
     ThreadArg * a = _a;
     char buf1[256], buf2[256];
-    for (int i = a->id; i < TOTAL_FILES; i += a->T) {
+    for (int i = a->id; i < total_files; i += a->T) {
+        if (file_done(i)) continue;
+        long long t0 = my_workers ? metrics_now_ns() : 0;
         int size = file_sizes[i];
-        apply_bwt(buf1, "content", size);
-        apply_mtf(buf2, buf1, size);
+        apply_bwt(buf1, sizeof(buf1), "content", size);
+        apply_mtf(buf2, sizeof(buf2), buf1, size);
         apply_rle(buf2, size);
+        emit_output(i, buf2);
+        if (my_workers) metrics_file_done(&my_workers[a->id], size, t0);
     }
     return NULL;
 }
@@ -111,160 +571,1287 @@ void run_thread_only(int T) {
         pthread_join(th[t], NULL);
 }
 
-// 작업 큐에 추가 (단계별 큐 사용)
-void enqueue_task(Task* task) {
-    pthread_mutex_lock(&queue_mutex);
-    switch (task->stage) {
-    case RAW:
-        raw_queue[raw_tail++] = task;
-        break;
-    case BWT_DONE:
-        bwt_queue[bwt_tail++] = task;
-        break;
-    case MTF_DONE:
-        mtf_queue[mtf_tail++] = task;
-        break;
+// 작업 하나가 admission 부터 완료까지 쓰는 메모리 추정치 (입출력 버퍼 + BWT 작업 메모리)
+static long long task_workset(const Task* task) {
+    return (long long)(BWT_WORKSET_FACTOR + 2) * task->cap;
+}
+
+// 예산 안에 들어가면 예약하고 0, 아니면 -1
+// 아무것도 진행 중이 아니면 예산보다 큰 작업이라도 하나는 들여보냄 (무한 대기 방지)
+int mem_try_reserve(long long bytes) {
+    int ok;
+    lockstat_lock(&mem_budget->lock, &lock_stats[LOCK_ADMISSION]);
+    ok = mem_budget->used == 0 || mem_budget->used + bytes <= mem_budget->limit;
+    if (ok) {
+        mem_budget->used += bytes;
+        if (mem_budget->used > mem_budget->peak) mem_budget->peak = mem_budget->used;
+    } else {
+        mem_budget->deferred++;
     }
-    pthread_cond_signal(&queue_not_empty);
-    pthread_mutex_unlock(&queue_mutex);
+    lockstat_unlock(&mem_budget->lock, &lock_stats[LOCK_ADMISSION]);
+    return ok ? 0 : -1;
 }
 
-// 우선순위가 가장 높은 작업을 큐에서 꺼냄
-Task* dequeue_highest_priority_task() {
-    pthread_mutex_lock(&queue_mutex);
-    while (raw_head == raw_tail && bwt_head == bwt_tail && mtf_head == mtf_tail) {
-        pthread_cond_wait(&queue_not_empty, &queue_mutex);
+void mem_release(long long bytes) {
+    lockstat_lock(&mem_budget->lock, &lock_stats[LOCK_COMPLETION]);
+    mem_budget->used -= bytes;
+    lockstat_unlock(&mem_budget->lock, &lock_stats[LOCK_COMPLETION]);
+}
+
+// 공유 예산 생성 (fork 전에 호출), 실패하면 NULL
+MemBudget* mem_budget_create(long long limit) {
+    MemBudget* b = mmap(NULL, sizeof(MemBudget), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (b == MAP_FAILED) return NULL;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&b->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    b->limit = limit;
+    b->used = b->peak = 0;
+    b->deferred = 0;
+    return b;
+}
+
+// 단계 출력을 다음 단계 입력으로 넘김 (포인터 교체)
+static inline void swap_buffers(Task* task) {
+    char* t = task->in;
+    task->in = task->out;
+    task->out = t;
+}
+
+// 뮤텍스 획득 (배치 효과 측정용으로 횟수를 셈, s 는 호출 위치의 프로파일 칸)
+static inline void counted_lock(pthread_mutex_t* m, LockStat* s) {
+    lockstat_lock(m, s);
+    __atomic_add_fetch(&lock_count, 1, __ATOMIC_RELAXED);
+    if (proc_metrics) metrics_add(&proc_metrics->locks, 1);
+}
+
+// 큐 깊이 지표 (queue_mutex 를 잡고 호출)
+static inline void metrics_queue_depth() {
+    metrics_set(&proc_metrics->ready_depth, ready_queue.len);
+    metrics_set(&proc_metrics->pending_depth, pending_queue.len);
+}
+
+// 작업 n 개를 한 번의 잠금으로 큐에 추가
+void enqueue_tasks(Task** tasks, int n) {
+    counted_lock(&queue_mutex, &lock_stats[LOCK_ENQUEUE]);
+    for (int k = 0; k < n; k++) {
+        Task* task = tasks[k];
+        int rc = mem_budget && task->stage == RAW
+            ? taskq_push(&pending_queue, task, task->size)
+            : taskq_push(&ready_queue, task, policy->key(task, ready_queue.next_seq));
+        if (rc < 0) {
+            fprintf(stderr, "Task queue overflow (max %d).\n", ready_queue.cap);
+            exit(1);
+        }
+        if (proc_metrics) metrics_add(&proc_metrics->enqueued[task->stage], 1);
     }
-    Task* task = NULL;
-    if (mtf_head < mtf_tail) {
-        task = mtf_queue[mtf_head++];
-    } else if (bwt_head < bwt_tail) {
-        task = bwt_queue[bwt_head++];
-    } else if (raw_head < raw_tail) {
-        task = raw_queue[raw_head++];
+    if (proc_metrics) metrics_queue_depth();
+    if (n > 1) pthread_cond_broadcast(&queue_not_empty);
+    else pthread_cond_signal(&queue_not_empty);
+    lockstat_unlock(&queue_mutex, &lock_stats[LOCK_ENQUEUE]);
+}
+
+void enqueue_task(Task* task) {
+    enqueue_tasks(&task, 1);
+}
+
+// 배치에 더 넣을 수 있는지 (첫 작업은 크기와 무관하게 항상 넣음)
+static inline int batch_fits(int n, long units, const Task* next) {
+    return n < batch_max && (n == 0 || batch_units == 0 || units + next->size <= batch_units);
+}
+
+// 정책상 우선순위가 높은 순서로 최대 batch_max 개를 꺼냄 (최소 한 개, 개수 반환)
+int dequeue_batch(Task** out) {
+    counted_lock(&queue_mutex, &lock_stats[LOCK_DEQUEUE]);
+    int n = 0;
+    long units = 0;
+    while (1) {
+        // 이미 들어온 작업을 먼저 진행하고, 없을 때만 새 작업을 들임
+        while (!taskq_empty(&ready_queue) && batch_fits(n, units, ready_queue.heap[0].item)) {
+            out[n] = taskq_pop(&ready_queue);
+            units += out[n++]->size;
+        }
+        if (n == 0) {
+            while (!taskq_empty(&pending_queue) && batch_fits(n, units, pending_queue.heap[0].item) &&
+                mem_try_reserve(task_workset(pending_queue.heap[0].item)) == 0) {
+                out[n] = taskq_pop(&pending_queue);
+                units += out[n++]->size;
+            }
+        }
+        if (n > 0) break;
+        if (!taskq_empty(&pending_queue)) {
+            // 다른 프로세스의 반납은 조건 변수로 알 수 없으므로 짧게 자고 다시 확인
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += BUDGET_POLL_MS * 1000000L;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            lockstat_cond_timedwait(&queue_not_empty, &queue_mutex, &ts, &lock_stats[LOCK_DEQUEUE]);
+            continue;
+        }
+        lockstat_cond_wait(&queue_not_empty, &queue_mutex, &lock_stats[LOCK_DEQUEUE]);
     }
-    pthread_mutex_unlock(&queue_mutex);
-    return task;
+    dequeue_count++;
+    dequeued_tasks += n;
+    if (proc_metrics) {
+        for (int k = 0; k < n; k++)
+            metrics_add(&proc_metrics->dequeued[out[k]->stage], 1);
+        metrics_queue_depth();
+    }
+    lockstat_unlock(&queue_mutex, &lock_stats[LOCK_DEQUEUE]);
+    return n;
 }
 
-// 스레드가 수행할 작업 함수
+// 스레드가 수행할 작업 함수: 꺼낸 배치를 이어서 처리하고
+// 다음 단계로 넘길 작업은 배치가 끝난 뒤 한 번에, 완료는 자기 카운터와 래치로만 보고
 void* worker_thread(void* arg) {
+    WorkerCounter* me = arg;
+    WorkerMetrics* wm = my_workers ? &my_workers[me - worker_done] : NULL;
+    Task* batch[MAX_BATCH], * next[MAX_BATCH];
+    double done_ms[MAX_BATCH];
     while (1) {
-        Task* task = dequeue_highest_priority_task();
-        switch (task->stage) {
-        case RAW:
-            apply_bwt(task->data, task->data, task->size);
-            task->stage = BWT_DONE;
-            enqueue_task(task);
-            break;
-        case BWT_DONE:
-            apply_mtf(task->data, task->data, task->size);
-            task->stage = MTF_DONE;
-            enqueue_task(task);
-            break;
-        case MTF_DONE:
-            apply_rle(task->data, task->size);
-            pthread_mutex_lock(&complete_mutex);
-            completed_tasks++;
-            if (completed_tasks == task_target) {
-                pthread_cond_signal(&all_done);
+        int n = dequeue_batch(batch);
+        int requeue = 0, done = 0, reported = 0;
+        int stage_done[METRICS_STAGES] = { 0, 0, 0 };  // 처리한 단계 (RAW 를 꺼냈으면 bwt)
+        long long t0 = wm ? metrics_now_ns() : 0, in = 0, out = 0;
+        for (int k = 0; k < n; k++) {
+            Task* task = batch[k];
+            switch (task->stage) {
+            case RAW: {
+                // --mem-budget 일 때만 실제 BWT 처럼 접미사 배열 크기의 작업 메모리를 잡고 씀
+                // (예산이 RSS 에 반영되는지 보려는 것이므로, 예산이 없으면 할당도 memset 도 하지 않음)
+                char* ws = NULL;
+                if (mem_budget) {
+                    size_t ws_len = BWT_WORKSET_FACTOR * task->cap;
+                    ws = malloc(ws_len);
+                    if (ws) {
+                        memset(ws, 0, ws_len);
+                        __asm__ volatile("" : : "r"(ws) : "memory");  // 할당이 최적화로 사라지지 않게
+                    }
+                }
+                apply_bwt(task->out, task->cap, task->in, task->size);
+                free(ws);
+                swap_buffers(task);
+                task->stage = BWT_DONE;
+                next[requeue++] = task;
+                stage_done[RAW]++;
+                break;
+            }
+            case BWT_DONE:
+                apply_mtf(task->out, task->cap, task->in, task->size);
+                swap_buffers(task);
+                task->stage = MTF_DONE;
+                next[requeue++] = task;
+                stage_done[BWT_DONE]++;
+                break;
+            case MTF_DONE:
+                apply_rle(task->in, task->size);
+                for (int f = 0; f < task->nfiles; f++)
+                    emit_output(task->files[f], task->in);
+                // 완료를 알리기 전에 반납 (마지막 작업이면 곧바로 프로세스가 끝남)
+                if (mem_budget) mem_release(task_workset(task));
+                if (my_completion) {
+                    struct timeval now;
+                    gettimeofday(&now, NULL);
+                    done_ms[done] = (now.tv_sec - run_start.tv_sec) * 1000.0 + (now.tv_usec - run_start.tv_usec) / 1000.0;
+                }
+                reported += task->nfiles;
+                batch[done++] = task;  // 앞쪽 칸은 이미 처리했으므로 완료 목록으로 재사용
+                stage_done[MTF_DONE]++;
+                in += task->cap;
+                out += compressed_size(task->size);
+                break;
+            }
+        }
+        if (wm) {
+            for (int s = 0; s < METRICS_STAGES; s++)
+                if (stage_done[s]) metrics_add(&wm->done[s], stage_done[s]);
+            metrics_add_ll(&wm->bytes_in, in);
+            metrics_add_ll(&wm->bytes_out, out);
+            metrics_add_ll(&wm->busy_ns, metrics_now_ns() - t0);
+        }
+        if (requeue > 0) enqueue_tasks(next, requeue);
+        if (done == 0) continue;
+        if (mem_budget) pthread_cond_broadcast(&queue_not_empty);  // 이 프로세스의 admission 대기를 깨움
+        if (my_completion) {
+            for (int k = 0; k < done; k++) {
+                // solid 블록은 담긴 파일 모두가 이 시각에 완료
+                me->sum_ms += done_ms[k] * batch[k]->nfiles;
+                if (done_ms[k] > me->max_ms) me->max_ms = done_ms[k];
             }
-            pthread_mutex_unlock(&complete_mutex);
-            free(task->name);
-            free(task);
-            break;
+        }
+        me->files += reported;
+        for (int k = 0; k < done; k++)
+            free(batch[k]->name);  // Task 와 버퍼는 아레나 소유 (래치가 풀리면 해제되므로 먼저)
+        // 같은 래치의 작업은 이어진 만큼 한 번에 (래치가 풀린 뒤에는 그 작업들을 건드리지 않음)
+        for (int k = 0; k < done; ) {
+            Latch* l = batch[k]->latch;
+            int n = 0;
+            while (k < done && batch[k]->latch == l) {
+                k++;
+                n++;
+            }
+            latch_count_down(l, n);
         }
     }
     return NULL;
 }
 
-// 압축 실행 함수: 각 프로세스마다 실행
-void run_compressor(int thread_count, int proc_index, int total_proc) {
+// 파일 nfiles 개를 담는 작업 하나를 아레나에서 만듦 (여러 개면 solid 블록)
+static Task* make_task(Arena* arena, int* files, int nfiles) {
+    int size = 0;
+    for (int f = 0; f < nfiles; f++)
+        size += file_sizes[files[f]];
+    Task* task = arena_alloc(arena, sizeof(Task));
+    task->cap = TASK_BUF_BYTES(size);
+    task->in = arena_alloc(arena, task->cap);
+    task->out = arena_alloc(arena, task->cap);
+    snprintf(task->in, task->cap, "content");
+    char name[32];
+    snprintf(name, sizeof(name), nfiles > 1 ? "solid_%02d" : "file_%02d", files[0]);
+    task->name = strdup(name);
+    task->stage = RAW;
+    task->size = size;
+    task->file = files[0];
+    task->files = files;
+    task->nfiles = nfiles;
+    return task;
+}
+
+// 워커 스레드를 띄움 (프로세스마다 한 번, 스레드는 끝나지 않고 큐를 기다림)
+int start_workers(int thread_count) {
     if (thread_count <= 0) {
         fprintf(stderr, "Invalid thread_count (must be ≥ 1).\n");
-        return;
+        return -1;
+    }
+    worker_done = worker_counters_create(thread_count);
+    if (!worker_done) {
+        fprintf(stderr, "Failed to allocate %d worker counters.\n", thread_count);
+        return -1;
     }
-    pthread_t threads[thread_count];
     for (int i = 0; i < thread_count; i++) {
-        pthread_create(&threads[i], NULL, worker_thread, NULL);
+        pthread_t tid;
+        pthread_create(&tid, NULL, worker_thread, &worker_done[i]);
+    }
+    return 0;
+}
+
+// 파일 목록의 작업을 만드는 데 필요한 아레나 크기 (Task, 입출력 버퍼, 파일 목록)
+static size_t tasks_arena_bytes(const int* list, int count) {
+    size_t bytes = arena_size(sizeof(int) * count);
+    for (int k = 0; k < count; k++)
+        bytes += arena_size(sizeof(Task)) + 2 * arena_size(TASK_BUF_BYTES(file_sizes[list[k]]));
+    return bytes;
+}
+
+// 파일 목록으로 작업을 만들고 개수 반환 (solid 로 묶이면 파일 수보다 작음)
+// 파일 목록: 큰 파일은 앞쪽부터 한 칸씩, solid 로 묶을 작은 파일은 뒤쪽에 이어서
+static int plan_tasks(Arena* arena, const int* list, int count, Task** made, Latch* latch) {
+    int* members = arena_alloc(arena, sizeof(int) * count);
+    int small = 0;
+    for (int k = 0; k < count; k++)
+        if (file_sizes[list[k]] < solid_units) small++;
+    int ntasks = 0, big = 0, tail = count - small;
+    for (int k = 0; k < count; k++) {
+        int i = list[k];
+        if (file_sizes[i] < solid_units) {
+            members[tail++] = i;
+            continue;
+        }
+        members[big] = i;
+        made[ntasks++] = make_task(arena, &members[big++], 1);
+    }
+    // 작은 파일은 합계가 solid_units 에 닿을 때까지 하나의 작업으로
+    for (int k = count - small; k < count; ) {
+        int first = k, units = 0;
+        while (k < count && units < solid_units)
+            units += file_sizes[members[k++]];
+        made[ntasks++] = make_task(arena, &members[first], k - first);
+    }
+    for (int k = 0; k < ntasks; k++)
+        made[k]->latch = latch;
+    return ntasks;
+}
+
+// 작업을 batch_max 개씩 큐에 넣음
+static void enqueue_all(Task** made, int ntasks) {
+    for (int k = 0; k < ntasks; k += batch_max)
+        enqueue_tasks(made + k, ntasks - k < batch_max ? ntasks - k : batch_max);
+}
+
+// 워커별 카운터를 이 프로세스의 완료 통계 칸에 합산하고 다음 실행을 위해 비움
+static void record_completion(int thread_count, long long bytes) {
+    if (!my_completion) return;
+    for (int i = 0; i < thread_count; i++) {
+        my_completion->count += worker_done[i].files;
+        my_completion->sum_ms += worker_done[i].sum_ms;
+        if (worker_done[i].max_ms > my_completion->max_ms) my_completion->max_ms = worker_done[i].max_ms;
+        worker_done[i].files = 0;
+        worker_done[i].sum_ms = worker_done[i].max_ms = 0.0;
+    }
+    my_completion->locks = __atomic_load_n(&lock_count, __ATOMIC_RELAXED);
+    my_completion->bytes = bytes;
+    my_completion->dequeues = dequeue_count;
+    my_completion->dequeued = dequeued_tasks;
+    memcpy(my_completion->lock_stats, lock_stats, sizeof(lock_stats));
+}
+
+// 압축 실행 함수: 각 프로세스마다 실행
+void run_compressor(int thread_count, int proc_index, int total_proc) {
+    if (start_workers(thread_count) < 0) return;
+    int* list = malloc(sizeof(int) * (total_files / total_proc + 1));
+    if (!list) {
+        fprintf(stderr, "Failed to allocate the file list.\n");
+        return;
     }
     int count = 0;
-    for (int i = proc_index; i < TOTAL_FILES; i += total_proc) count++;
-    task_target = count;
-    for (int i = proc_index; i < TOTAL_FILES; i += total_proc) {
-        Task* task = malloc(sizeof(Task));
-        strncpy(task->data, "content", sizeof(task->data));
-        char name[32];
-        snprintf(name, sizeof(name), "file_%02d", i);
-        task->name = strdup(name);
-        task->stage = RAW;
-        task->size = file_sizes[i];
-        enqueue_task(task);
-    }
-    pthread_mutex_lock(&complete_mutex);
-    while (completed_tasks < task_target)
-        pthread_cond_wait(&all_done, &complete_mutex);
-    pthread_mutex_unlock(&complete_mutex);
+    for (int i = proc_index; i < total_files; i += total_proc)
+        if (!file_done(i)) list[count++] = i;
+    if (count == 0) return;  // --resume: 이 프로세스 몫은 모두 끝남
+
+    // 대기열은 맡은 작업이 한꺼번에 들어가도 넘치지 않게 (작업마다 한 칸만 차지)
+    TaskQEntry* queue_storage = malloc(sizeof(TaskQEntry) * count * 2);
+    if (!queue_storage) {
+        fprintf(stderr, "Failed to allocate queues for %d tasks.\n", count);
+        return;
+    }
+    pthread_mutex_lock(&queue_mutex);
+    taskq_init(&ready_queue, queue_storage, count);
+    taskq_init(&pending_queue, queue_storage + count, count);
+    pthread_mutex_unlock(&queue_mutex);
+
+    // 이 프로세스가 맡은 작업의 Task 와 버퍼를 한 번에 할당
+    Arena arena;
+    size_t arena_bytes = tasks_arena_bytes(list, count);
+    if (arena_init(&arena, arena_bytes) < 0) {
+        fprintf(stderr, "Failed to allocate %zu bytes of task buffers.\n", arena_bytes);
+        return;
+    }
+    Task** made = malloc(sizeof(Task*) * count);
+    if (!made) {
+        fprintf(stderr, "Failed to allocate %d task slots.\n", count);
+        return;
+    }
+    int ntasks = plan_tasks(&arena, list, count, made, &tasks_left);
+
+    // 래치를 작업 수로 맞춘 뒤에 넣음
+    latch_init(&tasks_left, ntasks);
+    long long bytes = 0;
+    for (int k = 0; k < ntasks; k++)
+        bytes += made[k]->cap;
+    enqueue_all(made, ntasks);
+    latch_wait(&tasks_left);
+    record_completion(thread_count, bytes);
+    free(made);
+    free(list);
+    arena_destroy(&arena);
+    free(queue_storage);
 }
 
-// 메인 함수: 전체 프로세스를 생성하고 성능 측정
-int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <process_count> <thread_count>\n", argv[0]);
-        return 1;
+// ── 프로세스 풀 (--pool, hybrid 모드) ──
+// 자식 P 개를 프로그램 시작 직후 한 번만 fork (작업 목록과 버퍼를 만들기 전이라 복사할 페이지 테이블이 작음)
+// 부모는 파일 크기를 청크 단위로 공유 메모리 링에 넣고, 자식은 청크를 꺼내 자기 스레드 풀로 처리
+// 자식은 청크 두 개를 겹쳐서 처리 (한 청크의 마지막 작업이 도는 동안 다음 청크가 큐에 있음)
+
+#define POOL_CHUNK 256     // 청크 하나의 최대 파일 수
+#define POOL_RING 64       // 링의 청크 칸 수
+#define POOL_SPLIT 4       // 자식 하나당 청크 수 목표 (파일이 적으면 청크를 잘게)
+#define POOL_INFLIGHT 2    // 자식이 동시에 처리하는 청크 수
+#define POOL_CHECK_MS 100  // 부모가 기다리는 동안 자식이 죽었는지 확인하는 주기
+
+typedef struct {
+    int count;
+    int sizes[POOL_CHUNK];
+} PoolChunk;
+
+typedef struct {
+    pid_t pid;
+    struct rusage usage;  // 마지막 실행 동안의 자원 사용량 (getrusage 차이)
+} PoolChild;
+
+typedef struct {
+    pthread_mutex_t lock;  // PTHREAD_PROCESS_SHARED
+    pthread_cond_t work;   // 새 실행 또는 새 청크 (자식이 기다림)
+    pthread_cond_t space;  // 링에 빈 칸 (부모가 기다림)
+    pthread_cond_t idle;   // 자식 하나가 실행을 끝냄 (부모가 기다림)
+    int run_id;            // 실행마다 1 씩 증가
+    int ending;            // 이번 실행의 청크를 모두 넣었음
+    int closing;           // 풀 종료
+    int finished;          // 이번 실행을 끝낸 자식 수
+    long head, tail;       // 다음에 꺼낼/넣을 청크 번호
+    struct timeval run_start;
+    int time_multiplier;   // 작업 목록과 함께 정해지는 값 (fork 뒤에 바뀌므로 실행마다 전달)
+    size_t bytes_per_unit;
+    PoolChunk ring[POOL_RING];
+    PoolChild child[];     // 자식 수만큼
+} PoolShared;
+
+// 자식이 처리 중인 청크 하나
+typedef struct {
+    Latch left;
+    Arena arena;
+    Task* made[POOL_CHUNK];
+    int ntasks;
+} PoolBatch;
+
+int use_pool = 0;
+PoolShared* pool = NULL;
+size_t pool_len = 0;
+int pool_size = 0;
+int pool_sizes[POOL_INFLIGHT * POOL_CHUNK];  // 자식의 file_sizes (청크 칸마다 POOL_CHUNK 개)
+
+// 다음 청크의 파일 크기를 sizes 에 복사하고 개수 반환 (이번 실행이 끝났으면 0)
+static int pool_take(int* sizes) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->head == pool->tail && !pool->ending)
+        pthread_cond_wait(&pool->work, &pool->lock);
+    int n = 0;
+    if (pool->head != pool->tail) {
+        PoolChunk* c = &pool->ring[pool->head % POOL_RING];
+        n = c->count;
+        memcpy(sizes, c->sizes, sizeof(int) * n);
+        pool->head++;
+        pthread_cond_signal(&pool->space);
     }
-    int P = atoi(argv[1]);    // 자식 프로세스 수
-    int T = atoi(argv[2]);    // 워커 스레드 수
-    PerfMetrics metrics;
+    pthread_mutex_unlock(&pool->lock);
+    return n;
+}
+
+// 청크 하나를 꺼내 작업을 만들고 큐에 넣음 (base: 이 칸의 file_sizes 시작 위치)
+static int pool_batch_start(PoolBatch* b, int base, long long* bytes) {
+    int n = pool_take(&file_sizes[base]);
+    if (n == 0) return 0;
+    int list[POOL_CHUNK];
+    for (int k = 0; k < n; k++)
+        list[k] = base + k;
+    size_t arena_bytes = tasks_arena_bytes(list, n);
+    if (arena_init(&b->arena, arena_bytes) < 0) {
+        fprintf(stderr, "Failed to allocate %zu bytes of task buffers.\n", arena_bytes);
+        exit(1);
+    }
+    b->ntasks = plan_tasks(&b->arena, list, n, b->made, &b->left);
+    latch_init(&b->left, b->ntasks);
+    for (int k = 0; k < b->ntasks; k++)
+        *bytes += b->made[k]->cap;
+    enqueue_all(b->made, b->ntasks);
+    return 1;
+}
+
+static void rusage_delta(struct rusage* d, const struct rusage* before, const struct rusage* after) {
+    memset(d, 0, sizeof(*d));
+    timersub(&after->ru_utime, &before->ru_utime, &d->ru_utime);
+    timersub(&after->ru_stime, &before->ru_stime, &d->ru_stime);
+    d->ru_nvcsw = after->ru_nvcsw - before->ru_nvcsw;
+    d->ru_nivcsw = after->ru_nivcsw - before->ru_nivcsw;
+    d->ru_maxrss = after->ru_maxrss;
+}
+
+// 자식: 실행 하나의 청크를 모두 처리 (가장 오래된 청크가 끝나면 그 칸에 다음 청크)
+static void pool_child_run(int thread_count, int index) {
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    run_start = pool->run_start;
+    time_multiplier = pool->time_multiplier;
+    bytes_per_unit = pool->bytes_per_unit;
+    pthread_mutex_lock(&queue_mutex);
+    lock_count = 0;
+    dequeue_count = dequeued_tasks = 0;
+    memset(lock_stats, 0, sizeof(lock_stats));
+    pthread_mutex_unlock(&queue_mutex);
+
+    PoolBatch batches[POOL_INFLIGHT];
+    int live[POOL_INFLIGHT], active = 0;
+    long long bytes = 0;
+    for (int s = 0; s < POOL_INFLIGHT; s++) {
+        live[s] = pool_batch_start(&batches[s], s * POOL_CHUNK, &bytes);
+        active += live[s];
+    }
+    for (int s = 0; active > 0; s = (s + 1) % POOL_INFLIGHT) {
+        if (!live[s]) continue;
+        latch_wait(&batches[s].left);
+        arena_destroy(&batches[s].arena);
+        live[s] = pool_batch_start(&batches[s], s * POOL_CHUNK, &bytes);
+        active -= !live[s];
+    }
+    record_completion(thread_count, bytes);
+    getrusage(RUSAGE_SELF, &after);
+    rusage_delta(&pool->child[index].usage, &before, &after);
+}
+
+// 자식 본체: 스레드를 한 번 띄우고 실행이 올 때마다 처리, 풀이 닫히면 종료
+static void pool_child(int thread_count, int index) {
+    if (completion_stats) my_completion = &completion_stats[index];
+    metrics_bind(index);
+    file_sizes = pool_sizes;
+    if (start_workers(thread_count) < 0) exit(1);
+    // 대기열은 동시에 처리하는 청크의 작업이 모두 들어가도 넘치지 않게
+    int cap = POOL_INFLIGHT * POOL_CHUNK;
+    TaskQEntry* queue_storage = malloc(sizeof(TaskQEntry) * cap * 2);
+    if (!queue_storage) {
+        fprintf(stderr, "Failed to allocate queues for %d tasks.\n", cap);
+        exit(1);
+    }
+    pthread_mutex_lock(&queue_mutex);
+    taskq_init(&ready_queue, queue_storage, cap);
+    taskq_init(&pending_queue, queue_storage + cap, cap);
+    pthread_mutex_unlock(&queue_mutex);
+
+    int seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->closing && pool->run_id == seen)
+            pthread_cond_wait(&pool->work, &pool->lock);
+        if (pool->closing) break;
+        seen = pool->run_id;
+        pthread_mutex_unlock(&pool->lock);
+        pool_child_run(thread_count, index);
+        pthread_mutex_lock(&pool->lock);
+        pool->finished++;
+        pthread_cond_signal(&pool->idle);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    exit(0);
+}
+
+// 풀 종료: 자식에게 알리고 모두 회수
+void pool_stop() {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->closing = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool_size; i++)
+        waitpid(pool->child[i].pid, NULL, 0);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->space);
+    pthread_cond_destroy(&pool->idle);
+    munmap(pool, pool_len);
+    pool = NULL;
+    if (completion_stats) munmap(completion_stats, sizeof(CompletionStats) * pool_size);
+    completion_stats = NULL;
+}
+
+// 자식 P 개를 띄움 (큰 할당을 하기 전에 호출), 실패하면 -1
+int pool_start(int P, int T) {
+    pool_len = sizeof(PoolShared) + sizeof(PoolChild) * P;
+    pool = mmap(NULL, pool_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (pool == MAP_FAILED) {
+        perror("mmap failed");
+        pool = NULL;
+        return -1;
+    }
+    completion_stats = mmap(NULL, sizeof(CompletionStats) * P, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (completion_stats == MAP_FAILED) completion_stats = NULL;
+    pthread_mutexattr_t ma;
+    pthread_mutexattr_init(&ma);
+    pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&pool->lock, &ma);
+    pthread_mutexattr_destroy(&ma);
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED);
+    pthread_cond_init(&pool->work, &ca);
+    pthread_cond_init(&pool->space, &ca);
+    pthread_cond_init(&pool->idle, &ca);
+    pthread_condattr_destroy(&ca);
+    fflush(stdout);  // 자식이 버퍼를 중복 출력하지 않도록
+    for (pool_size = 0; pool_size < P; pool_size++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork failed");
+            pool_stop();
+            return -1;
+        }
+        if (pid == 0) pool_child(T, pool_size);
+        pool->child[pool_size].pid = pid;
+    }
+    return 0;
+}
+
+// 부모: 조건 변수를 기다리되 자식이 먼저 죽으면 중단 (잠금을 잡은 상태로 호출)
+static void pool_wait(pthread_cond_t* cond) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += POOL_CHECK_MS * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(cond, &pool->lock, &ts);
+    pid_t pid = waitpid(-1, NULL, WNOHANG);
+    if (pid > 0) {
+        fprintf(stderr, "Pool worker %d exited unexpectedly.\n", pid);
+        exit(1);
+    }
+}
+
+// 실행 하나를 풀에 맡기고 끝날 때까지 기다림 (end_perf 처럼 자식별 자원 사용량을 합산)
+void pool_run(PerfMetrics* metrics) {
+    int P = pool_size;
+    int chunk = (total_files + P * POOL_SPLIT - 1) / (P * POOL_SPLIT);
+    if (chunk < 1) chunk = 1;
+    if (chunk > POOL_CHUNK) chunk = POOL_CHUNK;
+    if (completion_stats) memset(completion_stats, 0, sizeof(CompletionStats) * P);
+    start_perf(metrics);
+    pthread_mutex_lock(&pool->lock);
+    pool->run_start = metrics->start_time;
+    pool->time_multiplier = time_multiplier;
+    pool->bytes_per_unit = bytes_per_unit;
+    pool->head = pool->tail = 0;
+    pool->ending = 0;
+    pool->finished = 0;
+    pool->run_id++;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < total_files; i += chunk) {
+        int n = total_files - i < chunk ? total_files - i : chunk;
+        pthread_mutex_lock(&pool->lock);
+        while (pool->tail - pool->head == POOL_RING)
+            pool_wait(&pool->space);
+        PoolChunk* c = &pool->ring[pool->tail % POOL_RING];
+        c->count = n;
+        memcpy(c->sizes, &file_sizes[i], sizeof(int) * n);
+        pool->tail++;
+        pthread_cond_signal(&pool->work);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->ending = 1;
+    pthread_cond_broadcast(&pool->work);
+    while (pool->finished < P)
+        pool_wait(&pool->idle);
+    pthread_mutex_unlock(&pool->lock);
+    gettimeofday(&metrics->end_time, NULL);
+
+    for (int i = 0; i < P; i++) {
+        const struct rusage* u = &pool->child[i].usage;
+        double user = u->ru_utime.tv_sec * 1000.0 + u->ru_utime.tv_usec / 1000.0;
+        double sys = u->ru_stime.tv_sec * 1000.0 + u->ru_stime.tv_usec / 1000.0;
+        printf("[PID %d] User Time: %.3f ms, Sys Time: %.3f ms\n", pool->child[i].pid, user, sys);
+        timeradd(&metrics->usage.ru_utime, &u->ru_utime, &metrics->usage.ru_utime);
+        timeradd(&metrics->usage.ru_stime, &u->ru_stime, &metrics->usage.ru_stime);
+        metrics->usage.ru_nvcsw += u->ru_nvcsw;
+        metrics->usage.ru_nivcsw += u->ru_nivcsw;
+        if (u->ru_maxrss > metrics->usage.ru_maxrss) metrics->usage.ru_maxrss = u->ru_maxrss;
+    }
+}
+
+// 프로세스별 완료 통계를 측정값에 합산
+static void collect_completion(PerfMetrics* metrics, int P) {
+    long count = 0;
+    double sum = 0.0;
+    for (int i = 0; i < P; i++) {
+        count += completion_stats[i].count;
+        sum += completion_stats[i].sum_ms;
+        if (completion_stats[i].max_ms > metrics->makespan_ms)
+            metrics->makespan_ms = completion_stats[i].max_ms;
+        metrics->lock_acquisitions += completion_stats[i].locks;
+        metrics->bytes_processed += completion_stats[i].bytes;
+        metrics->dequeues += completion_stats[i].dequeues;
+        metrics->dequeued_tasks += completion_stats[i].dequeued;
+        lockstat_merge(metrics->locks, completion_stats[i].lock_stats, LOCK_SITES);
+    }
+    metrics->lock_sites = lock_site_names;
+    metrics->lock_site_count = LOCK_SITES;
+    metrics->mean_completion_ms = count > 0 ? sum / count : 0.0;
+}
 
+// 모드 실행 함수: P, T 조합에 맞는 모드를 돌리고 측정값을 채움
+void run_strategy(int P, int T, PerfMetrics* metrics) {
     // ──── 1) 순차(single) 모드 (C0) ───────────────────────────────
     if (P == 0 && T == 0) {
-        start_perf(&metrics);
+        start_perf(metrics);
+        metrics_bind(0);
+        journal_start();
         char buf1[256], buf2[256];
-        for (int i = 0; i < TOTAL_FILES; i++) {
+        for (int i = 0; i < total_files; i++) {
+            if (file_done(i)) continue;
+            long long t0 = my_workers ? metrics_now_ns() : 0;
             int size = file_sizes[i];
-            apply_bwt(buf1, "content", size);
-            apply_mtf(buf2, buf1, size);
+            apply_bwt(buf1, sizeof(buf1), "content", size);
+            apply_mtf(buf2, sizeof(buf2), buf1, size);
             apply_rle(buf2, size);
+            emit_output(i, buf2);
+            if (my_workers) metrics_file_done(&my_workers[0], size, t0);
         }
-        end_perf(&metrics, 0);
-        print_perf_summary(&metrics);
-        return 0;
+        journal_stop();
+        end_perf(metrics, 0);
+        return;
     }
 
     // ──── 2) process-only 모드 (C1~C5) ───────────────────────────
     if (T == 0) {
-        start_perf(&metrics);
+        start_perf(metrics);
         for (int i = 0; i < P; i++) {
             if (fork() == 0) {
                 run_process_only(P, i);
                 exit(0);
             }
         }
-        end_perf(&metrics, P);
-        print_perf_summary(&metrics);
-        return 0;
+        end_perf(metrics, P);
+        return;
     }
 
     // ──── 3) thread-only 모드 (C6~C9) ────────────────────────────
     if (P == 0) {
-        start_perf(&metrics);
+        start_perf(metrics);
+        metrics_bind(0);
+        journal_start();
         run_thread_only(T);
-        end_perf(&metrics, 0);
-        print_perf_summary(&metrics);
-        return 0;
+        journal_stop();
+        end_perf(metrics, 0);
+        return;
     }
 
     // ──── 4) hybrid 모드 (C10~C14) ───────────────────────────────
-    start_perf(&metrics);
+    if (pool) {
+        pool_run(metrics);
+        if (completion_stats) collect_completion(metrics, pool_size);
+        return;
+    }
+    completion_stats = mmap(NULL, sizeof(CompletionStats) * P, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (completion_stats == MAP_FAILED) completion_stats = NULL;
+    if (mem_budget_limit > 0 && (mem_budget = mem_budget_create(mem_budget_limit)) == NULL)
+        perror("mmap failed (memory budget disabled)");
+    start_perf(metrics);
+    run_start = metrics->start_time;
     for (int i = 0; i < P; i++) {
         pid_t pid = fork();
         if (pid == 0) {
+            if (completion_stats) my_completion = &completion_stats[i];
+            metrics_bind(i);
+            journal_start();
             run_compressor(T, i, P);
+            journal_stop();
             exit(0);
         }
     }
-    end_perf(&metrics, P);
+    end_perf(metrics, P);
+    if (completion_stats) {
+        collect_completion(metrics, P);
+        munmap(completion_stats, sizeof(CompletionStats) * P);
+        completion_stats = NULL;
+    }
+    if (mem_budget) {
+        printf("[budget] peak %.2f / %.2f MB reserved, %ld admission retries\n",
+            mem_budget->peak / 1048576.0, mem_budget->limit / 1048576.0, mem_budget->deferred);
+        pthread_mutex_destroy(&mem_budget->lock);
+        munmap(mem_budget, sizeof(MemBudget));
+        mem_budget = NULL;
+    }
+}
+
+// --out 이 있으면 실행 전에 출력 파일을 잡고, 모든 자식이 끝난 뒤 인덱스를 마무리
+void run_mode(int P, int T, PerfMetrics* metrics) {
+    if (out_path && out_open(out_path) < 0) exit(1);
+    run_strategy(P, T, metrics);
+    if (out_map && out_finalize() < 0) exit(1);
+}
+
+// ── 자동 튜닝 (--auto): 호스트 구성을 읽고 짧은 보정 실행으로 P/T 와 정책 선택 ──
+
+#define CALIBRATION_STRIDE 4            // 보정 실행은 작업 목록에서 4개마다 하나씩 골라서
+#define CALIBRATION_FILES 256           // 최대 256개까지만 수행
+#define CALIBRATION_DIVISOR 20          // 배수도 1/20 로 줄임
+#define AUTOTUNE_CACHE ".pfc_autotune"  // $HOME 아래 호스트별 결정 캐시
+#define MAX_CANDIDATES 16
+
+typedef struct {
+    int logical;      // 온라인 논리 CPU 수
+    int physical;     // 물리 코어 수 (SMT 형제 제외)
+    double mem_gbps;  // memcpy 대역폭
+} HostInfo;
+
+// 물리 코어 수: (package, core_id) 쌍의 개수, 읽을 수 없으면 논리 CPU 수
+int count_physical_cores(int logical) {
+    int seen_pkg[1024], seen_core[1024], n = 0;
+    for (int cpu = 0; cpu < 1024 && n < 1024; cpu++) {
+        char path[128];
+        int pkg = 0, core = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        FILE* f = fopen(path, "r");
+        if (!f) {
+            if (cpu >= logical) break;
+            continue;
+        }
+        if (fscanf(f, "%d", &core) != 1) core = cpu;
+        fclose(f);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        f = fopen(path, "r");
+        if (f) {
+            if (fscanf(f, "%d", &pkg) != 1) pkg = 0;
+            fclose(f);
+        }
+        int dup = 0;
+        for (int i = 0; i < n; i++)
+            if (seen_pkg[i] == pkg && seen_core[i] == core) dup = 1;
+        if (!dup) {
+            seen_pkg[n] = pkg;
+            seen_core[n] = core;
+            n++;
+        }
+    }
+    return n > 0 && n <= logical ? n : logical;
+}
+
+// 64MB memcpy 를 몇 번 돌려서 대역폭(GB/s) 측정
+double measure_mem_bandwidth() {
+    size_t len = 64 << 20;
+    char* a = malloc(len), * b = malloc(len);
+    if (!a || !b) {
+        free(a); free(b);
+        return 0.0;
+    }
+    memset(a, 1, len);
+    memset(b, 2, len);
+    struct timeval t0, t1;
+    gettimeofday(&t0, NULL);
+    for (int i = 0; i < 4; i++) {
+        memcpy(i % 2 ? a : b, i % 2 ? b : a, len);
+        __asm__ volatile("" : : "r"(a), "r"(b) : "memory");  // 복사가 최적화로 사라지지 않게
+    }
+    gettimeofday(&t1, NULL);
+    double sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) / 1e6;
+    free(a); free(b);
+    return sec > 0 ? 4.0 * len / sec / 1e9 : 0.0;
+}
+
+// CPU 구성만 읽음 (캐시 키에 필요한 부분), 대역폭은 보정할 때만 measure_mem_bandwidth 로
+void detect_host(HostInfo* h) {
+    h->logical = sysconf(_SC_NPROCESSORS_ONLN);
+    if (h->logical < 1) h->logical = 1;
+    h->physical = count_physical_cores(h->logical);
+    h->mem_gbps = 0.0;
+}
+
+// 캐시 키: 호스트 이름 + 코어 구성 (구성이 바뀌면 다시 튜닝)
+void host_key(const HostInfo* h, char* key, size_t len) {
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    snprintf(key, len, "%s/%dc%dt", host, h->physical, h->logical);
+}
+
+void cache_path(char* path, size_t len) {
+    const char* home = getenv("HOME");
+    snprintf(path, len, "%s/%s", home ? home : ".", AUTOTUNE_CACHE);
+}
+
+// 캐시 한 줄: "키 P T 정책 ms" (정책이 없는 예전 줄은 P/T 만 사용)
+int load_cached_config(const char* key, int* P, int* T) {
+    char path[4096], line[512], k[300], name[32];
+    cache_path(path, sizeof(path));
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    int found = -1, p, t;
+    while (fgets(line, sizeof(line), f)) {
+        int n = sscanf(line, "%299s %d %d %31s", k, &p, &t, name);
+        if (n < 3 || strcmp(k, key) != 0) continue;
+        *P = p;
+        *T = t;
+        for (int i = 0; n == 4 && i < POLICY_COUNT; i++)
+            if (strcmp(name, policies[i].name) == 0) policy = &policies[i];
+        found = 0;
+        break;
+    }
+    fclose(f);
+    return found;
+}
+
+// 같은 키의 줄을 새 결정으로 바꿔서 파일 전체를 다시 씀 (임시 파일에 쓰고 rename)
+void save_cached_config(const char* key, int P, int T, double ms) {
+    char path[4096], tmp[4200], line[512], k[300];
+    cache_path(path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+    FILE* out = fopen(tmp, "w");
+    if (!out) {
+        perror(tmp);
+        return;
+    }
+    FILE* in = fopen(path, "r");
+    if (in) {
+        while (fgets(line, sizeof(line), in)) {
+            if (sscanf(line, "%299s", k) == 1 && strcmp(k, key) == 0) continue;
+            fputs(line, out);
+        }
+        fclose(in);
+    }
+    fprintf(out, "%s %d %d %s %.3f\n", key, P, T, policy->name, ms);
+    if (fclose(out) != 0 || rename(tmp, path) < 0) {
+        perror(path);
+        unlink(tmp);
+    }
+}
+
+// 후보 하나를 축소된 부하로 자식 프로세스에서 실행하고 벽시계 시간(ms) 반환
+//   작업 목록은 일정 간격으로 CALIBRATION_STRIDE 개마다 하나, 최대 CALIBRATION_FILES 개만 뽑음
+//   (앞쪽만 자르지 않고 고르게 뽑아서 크기 분포는 유지)
+double calibrate(int P, int T) {
+    struct timeval t0, t1;
+    fflush(stdout);  // 자식이 버퍼를 중복 출력하지 않도록
+    gettimeofday(&t0, NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!freopen("/dev/null", "w", stdout)) _exit(1);
+        out_path = NULL;  // 보정 실행은 결과 파일을 쓰지 않음
+        time_multiplier = time_multiplier / CALIBRATION_DIVISOR > 0 ? time_multiplier / CALIBRATION_DIVISOR : 1;
+        int n = (total_files + CALIBRATION_STRIDE - 1) / CALIBRATION_STRIDE;
+        if (n > CALIBRATION_FILES) n = CALIBRATION_FILES;
+        for (int i = 0; i < n; i++)  // 뽑는 위치가 항상 i 이상이라 제자리에서 모아도 됨
+            file_sizes[i] = file_sizes[(long)i * total_files / n];
+        total_files = n;
+        PerfMetrics m;
+        run_mode(P, T, &m);
+        _exit(0);
+    }
+    if (pid < 0) {
+        perror("fork failed");
+        return -1.0;
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    gettimeofday(&t1, NULL);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1.0;
+    return (t1.tv_sec - t0.tv_sec) * 1000.0 + (t1.tv_usec - t0.tv_usec) / 1000.0;
+}
+
+// 후보 구성: 순차, 물리 코어 기준 프로세스/스레드/하이브리드,
+// 대역폭이 충분하면 SMT 까지 채운 구성도 포함
+int build_candidates(const HostInfo* h, int cand[][2]) {
+    int n = 0, pc = h->physical, lc = h->logical;
+    cand[n][0] = 0; cand[n][1] = 0; n++;
+    cand[n][0] = pc; cand[n][1] = 0; n++;
+    cand[n][0] = 0; cand[n][1] = pc; n++;
+    for (int p = 2; p < pc && n < MAX_CANDIDATES - 2; p++) {
+        if (pc % p == 0) {
+            cand[n][0] = p; cand[n][1] = pc / p; n++;
+        }
+    }
+    // 논리 CPU 당 2GB/s 미만이면 SMT 형제끼리 대역폭만 나눠 쓰므로 제외
+    if (lc > pc && h->mem_gbps / lc >= 2.0) {
+        cand[n][0] = 0; cand[n][1] = lc; n++;
+        cand[n][0] = lc / pc; cand[n][1] = pc; n++;
+    }
+    return n;
+}
+
+// --auto: 캐시가 있으면 바로 사용, 없으면(또는 --retune) 보정 후 저장
+//   1단계: 후보 P/T 를 현재 정책으로 비교
+//   2단계: 고른 구성이 hybrid 이고 --policy 를 주지 않았으면 그 구성에서 정책끼리 비교
+//          (정책은 hybrid 모드의 작업 큐에만 쓰이므로 P/T × 정책 전체를 돌리지 않음)
+void auto_tune(int retune, int policy_fixed, int* P, int* T) {
+    HostInfo h;
+    detect_host(&h);
+    char key[300];
+    host_key(&h, key, sizeof(key));
+    const Policy* requested = policy;
+    if (!retune && load_cached_config(key, P, T) == 0) {
+        if (policy_fixed) policy = requested;
+        printf("[auto] %s: cached P=%d T=%d policy=%s\n", key, *P, *T, policy->name);
+        fflush(stdout);
+        return;
+    }
+
+    h.mem_gbps = measure_mem_bandwidth();  // 캐시에 없을 때만 (128MB 를 만지므로)
+    printf("[auto] %s: %d physical / %d logical CPUs, memcpy %.1f GB/s\n", key, h.physical, h.logical, h.mem_gbps);
+    int cand[MAX_CANDIDATES][2];
+    int n = build_candidates(&h, cand);
+    double best = -1.0;
+    *P = 0;
+    *T = 0;
+    for (int i = 0; i < n; i++) {
+        double ms = calibrate(cand[i][0], cand[i][1]);
+        printf("[auto]   P=%-3d T=%-3d %-6s %9.3f ms\n", cand[i][0], cand[i][1], policy->name, ms);
+        if (ms >= 0 && (best < 0 || ms < best)) {
+            best = ms;
+            *P = cand[i][0];
+            *T = cand[i][1];
+        }
+    }
+    if (*P > 0 && *T > 0 && !policy_fixed) {
+        const Policy* chosen = policy;
+        for (int i = 0; i < POLICY_COUNT; i++) {
+            if (&policies[i] == chosen) continue;  // 1단계에서 이미 측정
+            policy = &policies[i];
+            double ms = calibrate(*P, *T);
+            printf("[auto]   P=%-3d T=%-3d %-6s %9.3f ms\n", *P, *T, policy->name, ms);
+            if (ms >= 0 && ms < best) {
+                best = ms;
+                chosen = policy;
+            }
+        }
+        policy = chosen;
+    }
+    printf("[auto] selected P=%d T=%d policy=%s\n", *P, *T, policy->name);
+    fflush(stdout);
+    save_cached_config(key, *P, *T, best);
+}
+
+// ── 자식 시작 비용 측정 (--spawn-bench [max_MB]) ──
+// 부모가 RSS 만큼 메모리를 만져 둔 상태에서 자식 P 개를 띄우고 모두 회수할 때까지의 시간
+//   fork: 페이지 테이블을 복사 (RSS 에 비례), 자식은 바로 _exit
+//   vfork+exec, posix_spawn: 주소 공간을 복사하지 않고 이 프로그램을 SPAWN_NOOP_ARG 로 다시 실행
+
+#define SPAWN_NOOP_ARG "--spawn-noop"  // 바로 종료하는 실행 (exec 대상)
+#define SPAWN_BENCH_MAX_MB 256
+#define SPAWN_BENCH_REPS 5             // 조합마다 반복해서 중앙값
+
+typedef enum { SPAWN_FORK, SPAWN_VFORK, SPAWN_POSIX } SpawnKind;
+
+extern char** environ;
+
+// 자식 하나를 띄움, 실패하면 -1
+static int spawn_one(SpawnKind kind, const char* exe, pid_t* pid) {
+    char* args[] = { (char*)exe, SPAWN_NOOP_ARG, NULL };
+    if (kind == SPAWN_POSIX) return posix_spawn(pid, exe, NULL, NULL, args, environ) == 0 ? 0 : -1;
+    *pid = kind == SPAWN_FORK ? fork() : vfork();
+    if (*pid == 0) {
+        if (kind == SPAWN_FORK) _exit(0);
+        execve(exe, args, environ);
+        _exit(127);  // exec 실패: 셸과 posix_spawn 처럼 127, spawn_time 이 실패로 봄
+    }
+    return *pid < 0 ? -1 : 0;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// 자식 P 개를 띄우고 모두 회수하는 시간의 중앙값 (ms), 실패하면 -1
+static double spawn_time(SpawnKind kind, const char* exe, int P) {
+    double samples[SPAWN_BENCH_REPS];
+    pid_t pids[P];
+    for (int r = 0; r < SPAWN_BENCH_REPS; r++) {
+        struct timeval t0, t1;
+        int started = 0, failed = 0;
+        gettimeofday(&t0, NULL);
+        while (started < P && spawn_one(kind, exe, &pids[started]) == 0)
+            started++;
+        for (int i = 0; i < started; i++) {
+            int status;
+            if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = 1;
+        }
+        gettimeofday(&t1, NULL);
+        if (started < P || failed) return -1.0;
+        samples[r] = (t1.tv_sec - t0.tv_sec) * 1000.0 + (t1.tv_usec - t0.tv_usec) / 1000.0;
+    }
+    qsort(samples, SPAWN_BENCH_REPS, sizeof(double), compare_double);
+    return samples[SPAWN_BENCH_REPS / 2];
+}
+
+int spawn_bench(int max_mb) {
+    char exe[4096];
+    ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (len < 0) {
+        perror("readlink /proc/self/exe failed");
+        return 1;
+    }
+    exe[len] = '\0';
+    size_t max_bytes = (size_t)max_mb * 1024 * 1024;
+    char* mem = NULL;
+    if (max_bytes > 0) {
+        mem = mmap(NULL, max_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            perror("mmap failed");
+            return 1;
+        }
+    }
+    static const int procs[] = { 1, 2, 4, 8, 16 };
+    static const char* kinds[] = { "fork", "vfork+exec", "posix_spawn" };
+    printf("[spawn] ms to start and reap P children (median of %d), parent RSS touched beforehand\n", SPAWN_BENCH_REPS);
+    printf("%8s %4s %12s %12s %12s\n", "RSS MB", "P", kinds[0], kinds[1], kinds[2]);
+    fflush(stdout);  // fork 한 자식이 버퍼를 중복 출력하지 않도록
+    size_t touched = 0;
+    // RSS 0, 16, 64, 256, ... MB (max_MB 까지, 마지막은 max_MB)
+    for (int mb = 0; ; mb = mb == 0 ? 16 : mb * 4) {
+        if (mb > max_mb) mb = max_mb;
+        size_t want = (size_t)mb * 1024 * 1024;
+        if (want > touched) {
+            memset(mem + touched, 1, want - touched);
+            touched = want;
+        }
+        for (int p = 0; p < (int)(sizeof(procs) / sizeof(procs[0])); p++) {
+            printf("%8d %4d", mb, procs[p]);
+            for (int k = SPAWN_FORK; k <= SPAWN_POSIX; k++) {
+                double ms = spawn_time(k, exe, procs[p]);
+                if (ms < 0) printf(" %12s", "failed");
+                else printf(" %12.3f", ms);
+            }
+            printf("\n");
+            fflush(stdout);
+        }
+        if (mb >= max_mb) break;
+    }
+    if (mem) munmap(mem, max_bytes);
+    return 0;
+}
+
+// --metrics: 공유 지표 페이지를 만들고 서버 스레드 시작 (자식을 fork 하기 전에)
+int metrics_start(int P, int T) {
+    if (metrics_create(&metrics_page, P > 0 ? P : 1, T > 0 ? T : 1, total_files, stage_names) < 0) {
+        perror("mmap failed");
+        return -1;
+    }
+    if (metrics_serve(&metrics_page, metrics_path) < 0) {
+        metrics_close(&metrics_page);
+        return -1;
+    }
+    printf("[metrics] serving on %s\n", metrics_path);
+    fflush(stdout);
+    return 0;
+}
+
+// 메인 함수: 전체 프로세스를 생성하고 성능 측정
+int main(int argc, char* argv[]) {
+    int P, T;
+    int policy_fixed = 0;  // --policy 를 주면 --auto 도 그 정책을 그대로 사용
+    if (argc == 2 && strcmp(argv[1], SPAWN_NOOP_ARG) == 0) return 0;
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "--spawn-bench") == 0) {
+        int max_mb = argc == 3 ? atoi(argv[2]) : SPAWN_BENCH_MAX_MB;
+        if (max_mb < 0) {
+            fprintf(stderr, "Invalid RSS limit (must be ≥ 0 MB).\n");
+            return 1;
+        }
+        return spawn_bench(max_mb);
+    }
+    // 앞쪽 옵션
+    //   --policy <name>      작업 큐 스케줄링 정책 (hybrid 모드)
+    //   --mem-budget <MB>    모든 프로세스가 공유하는 작업 메모리 예산 (hybrid 모드)
+    //   --out <path>         결과를 공유 mmap 출력 파일 하나에 기록 (모든 모드)
+    //   --resume             --out 의 저널을 읽어 끝난 파일은 건너뛰고 이어서 실행
+    //   --workload <spec>    가상 작업 목록 (workload.h 참고, 기본은 60개 표)
+    //   --batch <K>          큐 잠금 한 번에 꺼내는 최대 작업 수 (hybrid 모드, 기본 1)
+    //   --batch-units <N>    배치 하나의 크기 합 상한 (파일 크기 단위)
+    //   --solid <N>          크기가 N 미만인 파일을 합계 N 까지 하나의 작업으로 묶음
+    //   --metrics <socket>   실행 중 지표를 Unix 소켓에 Prometheus 텍스트 형식으로 공개 (metrics.h)
+    //   --pool               hybrid 자식을 작업 목록을 만들기 전에 한 번만 fork 하고 공유 메모리 링으로 작업 전달
+    // 단독 옵션
+    //   --spawn-bench [MB]   fork / vfork+exec / posix_spawn 시작 비용을 P 와 RSS 별로 측정
+    const char* workload_spec = NULL;  // 풀을 띄운 뒤에 생성
+    workload_default(&workload);
+    while (argc >= 3 && strncmp(argv[1], "--", 2) == 0 && strcmp(argv[1], "--auto") != 0) {
+        if (strcmp(argv[1], "--resume") == 0) {
+            resume = 1;
+            argv[1] = argv[0];
+            argv++;
+            argc--;
+            continue;
+        }
+        if (strcmp(argv[1], "--pool") == 0) {
+            use_pool = 1;
+            argv[1] = argv[0];
+            argv++;
+            argc--;
+            continue;
+        }
+        if (strcmp(argv[1], "--policy") == 0) {
+            policy_fixed = 1;
+            policy = NULL;
+            for (int i = 0; i < POLICY_COUNT; i++)
+                if (strcmp(argv[2], policies[i].name) == 0) policy = &policies[i];
+            if (policy == NULL) {
+                fprintf(stderr, "Unknown policy '%s' (stage, fifo, sjf, lpt, aging).\n", argv[2]);
+                return 1;
+            }
+        } else if (strcmp(argv[1], "--workload") == 0) {
+            workload_spec = argv[2];
+        } else if (strcmp(argv[1], "--batch") == 0) {
+            batch_max = atoi(argv[2]);
+            if (batch_max < 1 || batch_max > MAX_BATCH) {
+                fprintf(stderr, "Invalid batch size (1 ~ %d).\n", MAX_BATCH);
+                return 1;
+            }
+        } else if (strcmp(argv[1], "--batch-units") == 0) {
+            batch_units = atoi(argv[2]);
+            if (batch_units < 1) {
+                fprintf(stderr, "Invalid batch units (must be ≥ 1).\n");
+                return 1;
+            }
+        } else if (strcmp(argv[1], "--solid") == 0) {
+            solid_units = atoi(argv[2]);
+            if (solid_units < 1) {
+                fprintf(stderr, "Invalid solid block size (must be ≥ 1).\n");
+                return 1;
+            }
+        } else if (strcmp(argv[1], "--out") == 0) {
+            out_path = argv[2];
+        } else if (strcmp(argv[1], "--metrics") == 0) {
+            metrics_path = argv[2];
+        } else if (strcmp(argv[1], "--mem-budget") == 0) {
+            mem_budget_limit = atoll(argv[2]) * 1024 * 1024;
+            if (mem_budget_limit <= 0) {
+                fprintf(stderr, "Invalid memory budget (must be ≥ 1 MB).\n");
+                return 1;
+            }
+        } else {
+            break;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    int autotune = 0, retune = 0;
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "--auto") == 0) {
+        retune = argc == 3 && strcmp(argv[2], "--retune") == 0;
+        if (argc == 3 && !retune) {
+            fprintf(stderr, "Usage: %s --auto [--retune]\n", argv[0]);
+            return 1;
+        }
+        autotune = 1;
+    } else if (argc == 3) {
+        P = atoi(argv[1]);    // 자식 프로세스 수
+        T = atoi(argv[2]);    // 워커 스레드 수
+    } else {
+        fprintf(stderr, "Usage: %s [--policy stage|fifo|sjf|lpt|aging] [--mem-budget MB] [--out path [--resume]] [--workload spec]\n"
+            "       [--batch K] [--batch-units N] [--solid N] [--pool] [--metrics socket] <process_count> <thread_count>\n", argv[0]);
+        fprintf(stderr, "       %s [--policy name] [--mem-budget MB] [--out path [--resume]] [--workload spec] --auto [--retune]\n", argv[0]);
+        fprintf(stderr, "       %s --spawn-bench [max_rss_MB]\n", argv[0]);
+        return 1;
+    }
+    if (resume && out_path == NULL) {
+        fprintf(stderr, "--resume needs --out.\n");
+        return 1;
+    }
+    if (use_pool) {
+        if (autotune || out_path || mem_budget_limit > 0) {
+            fprintf(stderr, "--pool cannot be combined with --auto, --out or --mem-budget.\n");
+            return 1;
+        }
+        if (P < 1 || T < 1) {
+            fprintf(stderr, "--pool needs hybrid mode (process_count ≥ 1, thread_count ≥ 1).\n");
+            return 1;
+        }
+        // 작업 목록을 만들기 전에 fork (자식이 물려받는 주소 공간이 작을 때)
+        if (metrics_path && metrics_start(P, T) < 0) return 1;
+        if (pool_start(P, T) < 0) return 1;
+    }
+    if (workload_spec) {
+        free(workload.sizes);
+        if (workload_generate(&workload, workload_spec) < 0) {
+            pool_stop();
+            return 1;
+        }
+    }
+    total_files = workload.count;
+    file_sizes = workload.sizes;
+    if (workload.time_multiplier > 0) time_multiplier = workload.time_multiplier;
+    if (workload.bytes_per_unit > 0) bytes_per_unit = workload.bytes_per_unit;
+    if (autotune) auto_tune(retune, policy_fixed, &P, &T);
+    if (metrics_path && !metrics_page.hdr && metrics_start(P, T) < 0) return 1;
+    if (metrics_page.hdr) metrics_page.hdr->files = total_files;
+    workload_describe(&workload, stdout);
+    PerfMetrics metrics;
+    run_mode(P, T, &metrics);
     print_perf_summary(&metrics);
+    pool_stop();
+    metrics_close(&metrics_page);
     return 0;
 }
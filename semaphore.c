@@ -9,55 +9,62 @@
 #include <sys/wait.h>
 #include <sys/resource.h>
 #include "result.h"
+#include "arena.h"
+#include "workload.h"
+#include "latch.h"
 
-#define TOTAL_FILES 60
-#define MAX_TASKS 100
 #define TIME_MULTIPLIER 10000
 
 typedef enum { RAW, BWT_DONE, MTF_DONE, FINISHED = -1 } Stage;
 
+// in 을 읽어 out 에 쓰고 포인터만 교체 (같은 버퍼를 읽고 쓰지 않음)
 typedef struct {
     char* name;
-    char  data[256];
+    char* in;
+    char* out;
+    size_t cap;
     Stage stage;
     int size;
 } Task;
 
-Task* raw_queue[MAX_TASKS], * bwt_queue[MAX_TASKS], * mtf_queue[MAX_TASKS];
+Task** raw_queue, ** bwt_queue, ** mtf_queue;  // 프로세스가 맡은 작업 수만큼 할당
 int raw_head = 0, raw_tail = 0;
 int bwt_head = 0, bwt_tail = 0;
 int mtf_head = 0, mtf_tail = 0;
 
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t complete_mutex = PTHREAD_MUTEX_INITIALIZER;
 sem_t sem_raw, sem_bwt, sem_mtf;
 
-int completed_tasks = 0;
-int task_target = 0;
+// 완료 추적: 남은 작업 수 래치 (latch.h)
+Latch tasks_left;
 
-int file_sizes[TOTAL_FILES] = {
-    73, 18, 94, 26, 51, 62, 37, 89, 5, 43,
-    77, 14, 35, 68, 92, 10, 23, 81, 6, 57,
-    49, 87, 30, 1, 99, 64, 12, 46, 91, 28,
-    39, 83, 7, 58, 100, 22, 75, 33, 9, 67,
-    29, 56, 44, 15, 79, 2, 88, 11, 93, 16,
-    84, 31, 21, 60, 70, 4, 95, 36, 47, 8
-};
+// 작업 목록 (--workload, 기본은 60개 표)
+int total_files;
+int* file_sizes;
+int time_multiplier = TIME_MULTIPLIER;
 
 void run_cpu_for(int times) {
     volatile double dummy = 1.0;
-    for (int i = 0; i < times * TIME_MULTIPLIER; i++) {
+    for (int i = 0; i < times * time_multiplier; i++) {
         dummy *= 1.0000001;
     }
 }
 
+void swap_buffers(Task* task) {
+    char* t = task->in;
+    task->in = task->out;
+    task->out = t;
+}
+
 void apply_bwt(Task* task) {
     run_cpu_for(5 * task->size);
-    sprintf(task->data, "bwt(%s)", task->data);
+    snprintf(task->out, task->cap, "bwt(%s)", task->in);
+    swap_buffers(task);
 }
 void apply_mtf(Task* task) {
     run_cpu_for(3 * task->size);
-    sprintf(task->data, "mtf(%s)", task->data);
+    snprintf(task->out, task->cap, "mtf(%s)", task->in);
+    swap_buffers(task);
 }
 void apply_rle(Task* task) {
     run_cpu_for(2 * task->size);
@@ -86,11 +93,8 @@ void* worker_thread(void* arg) {
             }
             apply_rle(task);
             free(task->name);
-            free(task);
 
-            pthread_mutex_lock(&complete_mutex);
-            completed_tasks++;
-            pthread_mutex_unlock(&complete_mutex);
+            latch_count_down(&tasks_left, 1);
             continue;
         }
 
@@ -131,33 +135,49 @@ void run_compressor(int thread_count, int proc_index, int total_proc) {
     sem_init(&sem_bwt, 0, 0);
     sem_init(&sem_mtf, 0, 0);
 
+    int count = 0;
+    size_t arena_bytes = 0;
+    for (int i = proc_index; i < total_files; i += total_proc) {
+        count++;
+        arena_bytes += arena_size(sizeof(Task)) + 2 * arena_size(TASK_BUF_BYTES(file_sizes[i]));
+    }
+    // mtf 큐에는 마지막에 스레드 수만큼 종료 표시가 더 들어감
+    Task** queues = malloc(sizeof(Task*) * (count * 3 + thread_count));
+    if (!queues) {
+        fprintf(stderr, "Failed to allocate queues for %d tasks.\n", count);
+        return;
+    }
+    raw_queue = queues;
+    bwt_queue = queues + count;
+    mtf_queue = queues + 2 * count;
+    Arena arena;
+    if (arena_init(&arena, arena_bytes) < 0) {
+        fprintf(stderr, "Failed to allocate %zu bytes of task buffers.\n", arena_bytes);
+        free(queues);
+        return;
+    }
+    latch_init(&tasks_left, count);
+
     for (int i = 0; i < thread_count; i++)
         pthread_create(&threads[i], NULL, worker_thread, NULL);
 
-    for (int i = proc_index; i < TOTAL_FILES; i += total_proc) {
-        Task* task = malloc(sizeof(Task));
+    for (int i = proc_index; i < total_files; i += total_proc) {
+        Task* task = arena_alloc(&arena, sizeof(Task));
         task->name = strdup("file");
-        strcpy(task->data, "data");
+        task->cap = TASK_BUF_BYTES(file_sizes[i]);
+        task->in = arena_alloc(&arena, task->cap);
+        task->out = arena_alloc(&arena, task->cap);
+        snprintf(task->in, task->cap, "data");
         task->stage = RAW;
         task->size = file_sizes[i];
         pthread_mutex_lock(&mutex);
         enqueue(task, raw_queue, &raw_tail);
         pthread_mutex_unlock(&mutex);
         sem_post(&sem_raw);
-        pthread_mutex_lock(&complete_mutex);
-        task_target++;
-        pthread_mutex_unlock(&complete_mutex);
     }
 
-    while (1) {
-        pthread_mutex_lock(&complete_mutex);
-        if (completed_tasks >= task_target) {
-            pthread_mutex_unlock(&complete_mutex);
-            break;
-        }
-        pthread_mutex_unlock(&complete_mutex);
-        usleep(1000);
-    }
+    // 마지막 작업을 끝낸 워커가 깨워 줄 때까지 잠듦 (1ms 폴링 대신)
+    latch_wait(&tasks_left);
 
     for (int i = 0; i < thread_count; i++) {
         Task* dummy = malloc(sizeof(Task));
@@ -170,14 +190,23 @@ void run_compressor(int thread_count, int proc_index, int total_proc) {
 
     for (int i = 0; i < thread_count; i++)
         pthread_join(threads[i], NULL);
+    arena_destroy(&arena);
+    free(queues);
 }
 
 int main(int argc, char* argv[]) {
+    Workload workload;
+    if (workload_args(&argc, &argv, &workload) < 0) return 1;
     if (argc != 3) {
-        fprintf(stderr, "Usage: %s <process_count> <thread_count>\n", argv[0]);
+        fprintf(stderr, "Usage: %s [--workload spec] <process_count> <thread_count>\n", argv[0]);
         return 1;
     }
     int P = atoi(argv[1]), T = atoi(argv[2]);
+    total_files = workload.count;
+    file_sizes = workload.sizes;
+    if (workload.time_multiplier > 0) time_multiplier = workload.time_multiplier;
+    if (workload.bytes_per_unit > 0) bytes_per_unit = workload.bytes_per_unit;
+    workload_describe(&workload, stdout);
     PerfMetrics m;
     start_perf(&m);
     for (int i = 0; i < P; i++) {
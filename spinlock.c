@@ -8,8 +8,8 @@
 #include <sys/wait.h>
 #include <sys/resource.h>
 #include "result.h"
+#include "workload.h"
 
-#define TOTAL_FILES 60
 #define TIME_MULTIPLIER 10000
 
 typedef struct {
@@ -17,7 +17,9 @@ typedef struct {
     int size;
 } FileTask;
 
-FileTask file_tasks[TOTAL_FILES];
+FileTask* file_tasks;
+int total_files;
+int time_multiplier = TIME_MULTIPLIER;
 int next_index = 0;
 volatile int lock = 0;  // spinlock flag
 
@@ -33,7 +35,7 @@ void spin_unlock() {
 
 void run_cpu_for(int times) {
     volatile double dummy = 1.0;
-    for (int i = 0; i < times * 10000; i++) {
+    for (int i = 0; i < times * time_multiplier; i++) {
         dummy *= 1.0000001;
     }
 }
@@ -44,7 +46,7 @@ void* worker_thread(void* arg) {
         int index = next_index++;
         spin_unlock();
 
-        if (index >= TOTAL_FILES) break;
+        if (index >= total_files) break;
 
         FileTask* task = &file_tasks[index];
         run_cpu_for(5 * task->size);
@@ -65,7 +67,7 @@ void run_thread_only(int thread_count) {
 }
 
 void run_process_only(int process_count, int proc_index) {
-    for (int i = proc_index; i < TOTAL_FILES; i += process_count) {
+    for (int i = proc_index; i < total_files; i += process_count) {
         run_cpu_for(5 * file_tasks[i].size);
         run_cpu_for(3 * file_tasks[i].size);
         run_cpu_for(2 * file_tasks[i].size);
@@ -73,32 +75,34 @@ void run_process_only(int process_count, int proc_index) {
 }
 
 int main(int argc, char* argv[]) {
+    Workload workload;
+    if (workload_args(&argc, &argv, &workload) < 0) return 1;
     if (argc != 3) {
-        fprintf(stderr, "Usage: %s <num_processes> <num_threads>\n", argv[0]);
+        fprintf(stderr, "Usage: %s [--workload spec] <num_processes> <num_threads>\n", argv[0]);
         return 1;
     }
 
     int P = atoi(argv[1]);
     int T = atoi(argv[2]);
 
-    int sizes[60] = {
-        73, 18, 94, 26, 51, 62, 37, 89, 5, 43,
-        77, 14, 35, 68, 92, 10, 23, 81, 6, 57,
-        49, 87, 30, 1, 99, 64, 12, 46, 91, 28,
-        39, 83, 7, 58, 100, 22, 75, 33, 9, 67,
-        29, 56, 44, 15, 79, 2, 88, 11, 93, 16,
-        84, 31, 21, 60, 70, 4, 95, 36, 47, 8
-    };
-    for (int i = 0; i < TOTAL_FILES; i++) {
+    total_files = workload.count;
+    if (workload.time_multiplier > 0) time_multiplier = workload.time_multiplier;
+    workload_describe(&workload, stdout);
+    file_tasks = malloc(sizeof(FileTask) * total_files);
+    if (!file_tasks) {
+        fprintf(stderr, "Failed to allocate %d file tasks.\n", total_files);
+        return 1;
+    }
+    for (int i = 0; i < total_files; i++) {
         file_tasks[i].name = NULL;
-        file_tasks[i].size = sizes[i];
+        file_tasks[i].size = workload.sizes[i];
     }
 
     PerfMetrics metrics;
 
     if (P == 0 && T == 0) {
         start_perf(&metrics);
-        for (int i = 0; i < TOTAL_FILES; i++) {
+        for (int i = 0; i < total_files; i++) {
             run_cpu_for(5 * file_tasks[i].size);
             run_cpu_for(3 * file_tasks[i].size);
             run_cpu_for(2 * file_tasks[i].size);
@@ -0,0 +1,68 @@
+#ifndef TASKQ_H
+#define TASKQ_H
+
+// 작업 대기열용 이진 최소 힙: key 가 작은 것부터, 같으면 먼저 들어온 것부터
+// (key 계산은 스케줄링 정책이 담당, 잠금은 호출 측 책임)
+
+typedef struct {
+    long key;
+    long seq;  // 넣은 순서 (같은 key 끼리 FIFO)
+    void* item;
+} TaskQEntry;
+
+typedef struct {
+    TaskQEntry* heap;
+    int len;
+    int cap;
+    long next_seq;
+} TaskQ;
+
+static inline void taskq_init(TaskQ* q, TaskQEntry* storage, int cap) {
+    q->heap = storage;
+    q->len = 0;
+    q->cap = cap;
+    q->next_seq = 0;
+}
+
+static inline int taskq_less(const TaskQEntry* a, const TaskQEntry* b) {
+    return a->key < b->key || (a->key == b->key && a->seq < b->seq);
+}
+
+// 가득 차 있으면 -1
+static inline int taskq_push(TaskQ* q, void* item, long key) {
+    if (q->len == q->cap) return -1;
+    TaskQEntry e = { key, q->next_seq++, item };
+    int i = q->len++;
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (!taskq_less(&e, &q->heap[p])) break;
+        q->heap[i] = q->heap[p];
+        i = p;
+    }
+    q->heap[i] = e;
+    return 0;
+}
+
+// 비어 있으면 NULL
+static inline void* taskq_pop(TaskQ* q) {
+    if (q->len == 0) return NULL;
+    void* top = q->heap[0].item;
+    TaskQEntry last = q->heap[--q->len];
+    int i = 0;
+    while (1) {
+        int c = 2 * i + 1;
+        if (c >= q->len) break;
+        if (c + 1 < q->len && taskq_less(&q->heap[c + 1], &q->heap[c])) c++;
+        if (!taskq_less(&q->heap[c], &last)) break;
+        q->heap[i] = q->heap[c];
+        i = c;
+    }
+    q->heap[i] = last;
+    return top;
+}
+
+static inline int taskq_empty(const TaskQ* q) {
+    return q->len == 0;
+}
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef URING_H
+#define URING_H
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+// liburing 없이 raw syscall 로 쓰는 최소한의 io_uring 래퍼
+
+typedef struct {
+    int fd;
+    unsigned* sq_head, * sq_tail, * sq_mask, * sq_array;
+    unsigned* cq_head, * cq_tail, * cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ptr, * cq_ptr;
+    size_t sq_len, cq_len, sqes_len;
+    unsigned sq_entries;
+    unsigned to_submit;  // 채웠지만 아직 커널에 넘기지 않은 SQE 수
+} Uring;
+
+// 실패 시 -errno 반환 (ENOSYS/EPERM 이면 호출 측이 pread 경로로 대체)
+static inline int uring_init(Uring* r, unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(r, 0, sizeof(*r));
+    int fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0) return -errno;
+    r->fd = fd;
+    r->sq_entries = p.sq_entries;
+
+    r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    r->cq_ptr = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (r->sq_ptr == MAP_FAILED || r->cq_ptr == MAP_FAILED || r->sqes == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+
+    char* sq = r->sq_ptr;
+    r->sq_head = (unsigned*)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(sq + p.sq_off.array);
+    char* cq = r->cq_ptr;
+    r->cq_head = (unsigned*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static inline void uring_exit(Uring* r) {
+    munmap(r->sqes, r->sqes_len);
+    munmap(r->cq_ptr, r->cq_len);
+    munmap(r->sq_ptr, r->sq_len);
+    close(r->fd);
+}
+
+// 고정 버퍼 등록 (READ_FIXED/WRITE_FIXED 용)
+static inline int uring_register_buffers(Uring* r, const struct iovec* iov, unsigned n) {
+    if (syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_BUFFERS, iov, n) < 0) return -errno;
+    return 0;
+}
+
+// 빈 SQE 하나를 꺼냄 (링이 가득 차면 NULL)
+static inline struct io_uring_sqe* uring_get_sqe(Uring* r) {
+    unsigned head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *r->sq_tail + r->to_submit;
+    if (tail - head >= r->sq_entries) return NULL;
+    unsigned idx = tail & *r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sq_array[idx] = idx;
+    r->to_submit++;
+    return sqe;
+}
+
+// 쌓인 SQE 를 한 번에 제출하고 최소 wait_nr 개의 완료를 기다림
+static inline int uring_submit_and_wait(Uring* r, unsigned wait_nr) {
+    unsigned n = r->to_submit;
+    __atomic_store_n(r->sq_tail, *r->sq_tail + n, __ATOMIC_RELEASE);
+    r->to_submit = 0;
+    int ret;
+    do {
+        ret = syscall(__NR_io_uring_enter, r->fd, n, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+    return ret < 0 ? -errno : ret;
+}
+
+static inline struct io_uring_cqe* uring_peek_cqe(Uring* r) {
+    unsigned head = *r->cq_head;
+    if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+    return &r->cqes[head & *r->cq_mask];
+}
+
+static inline void uring_cqe_seen(Uring* r) {
+    __atomic_store_n(r->cq_head, *r->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef WALK_H
+#define WALK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+// 병렬 디렉터리 탐색: 작은 스레드 풀이 디렉터리 스택을 나눠 가지며
+// getdents64 로 항목을 크게 읽고 fstatat 으로 크기를 확인해서
+// 일반 파일을 찾는 즉시 콜백으로 넘긴다 (심볼릭 링크는 따라가지 않음)
+
+#define WALK_BUF_BYTES (64 * 1024)  // getdents64 한 번에 읽을 바이트
+
+// 발견한 파일마다 호출 (여러 스레드에서 동시에), path 의 소유권은 콜백으로 넘어감
+typedef void (*walk_fn)(void* ctx, char* path, const struct stat* st);
+
+// 커널의 linux_dirent64 레이아웃
+typedef struct {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+} WalkDirent;
+
+typedef struct {
+    char** stack;  // 아직 읽지 않은 디렉터리 경로
+    int count, cap;
+    int busy;      // 디렉터리를 읽고 있는 스레드 수 (0 이고 스택이 비면 끝)
+    int errors;
+    long dirs, files;
+    walk_fn fn;
+    void* ctx;
+    pthread_mutex_t mutex;
+    pthread_cond_t more;
+} Walk;
+
+static inline char* walk_join(const char* dir, const char* name) {
+    size_t dl = strlen(dir), nl = strlen(name);
+    int slash = dl > 0 && dir[dl - 1] != '/';
+    char* p = malloc(dl + slash + nl + 1);
+    if (!p) return NULL;
+    memcpy(p, dir, dl);
+    if (slash) p[dl] = '/';
+    memcpy(p + dl + slash, name, nl + 1);
+    return p;
+}
+
+// 디렉터리들을 스택에 한 번에 올림 (잠금 한 번)
+static inline int walk_push(Walk* w, char** dirs, int n) {
+    if (n == 0) return 0;
+    pthread_mutex_lock(&w->mutex);
+    if (w->count + n > w->cap) {
+        int cap = w->cap ? w->cap : 256;
+        while (cap < w->count + n) cap *= 2;
+        char** grown = realloc(w->stack, sizeof(char*) * cap);
+        if (!grown) {
+            pthread_mutex_unlock(&w->mutex);
+            return -1;
+        }
+        w->stack = grown;
+        w->cap = cap;
+    }
+    memcpy(w->stack + w->count, dirs, sizeof(char*) * n);
+    w->count += n;
+    if (n > 1) pthread_cond_broadcast(&w->more);
+    else pthread_cond_signal(&w->more);
+    pthread_mutex_unlock(&w->mutex);
+    return 0;
+}
+
+// 디렉터리 하나를 읽음: 파일은 바로 콜백, 하위 디렉터리는 모아서 스택에
+static inline void walk_dir(Walk* w, const char* path, char* buf, long* files) {
+    int dfd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd < 0) {
+        perror(path);
+        __atomic_fetch_add(&w->errors, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    char** subdirs = NULL;
+    int nsub = 0, subcap = 0;
+    long n;
+    while ((n = syscall(SYS_getdents64, dfd, buf, WALK_BUF_BYTES)) > 0) {
+        for (long off = 0; off < n; ) {
+            WalkDirent* e = (WalkDirent*)(buf + off);
+            off += e->d_reclen;
+            const char* name = e->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            int type = e->d_type;
+            struct stat st;
+            // 디렉터리는 d_type 만으로 충분, 파일은 크기가 필요하므로 fstatat
+            if (type != DT_DIR) {
+                if (type != DT_REG && type != DT_UNKNOWN) continue;
+                if (fstatat(dfd, name, &st, AT_SYMLINK_NOFOLLOW) < 0) continue;
+                type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+            }
+            if (type == DT_UNKNOWN) continue;
+            char* full = walk_join(path, name);
+            if (!full) {
+                __atomic_fetch_add(&w->errors, 1, __ATOMIC_RELAXED);
+                continue;
+            }
+            if (type == DT_REG) {
+                (*files)++;
+                w->fn(w->ctx, full, &st);
+                continue;
+            }
+            if (nsub == subcap) {
+                subcap = subcap ? subcap * 2 : 16;
+                char** grown = realloc(subdirs, sizeof(char*) * subcap);
+                if (!grown) {
+                    free(full);
+                    __atomic_fetch_add(&w->errors, 1, __ATOMIC_RELAXED);
+                    break;
+                }
+                subdirs = grown;
+            }
+            subdirs[nsub++] = full;
+        }
+    }
+    if (n < 0) {
+        perror(path);
+        __atomic_fetch_add(&w->errors, 1, __ATOMIC_RELAXED);
+    }
+    close(dfd);
+    if (walk_push(w, subdirs, nsub) < 0) {
+        for (int i = 0; i < nsub; i++) free(subdirs[i]);
+        __atomic_fetch_add(&w->errors, 1, __ATOMIC_RELAXED);
+    }
+    free(subdirs);
+}
+
+static inline void* walk_thread(void* arg) {
+    Walk* w = arg;
+    char* buf = malloc(WALK_BUF_BYTES);
+    long dirs = 0, files = 0;
+    pthread_mutex_lock(&w->mutex);
+    while (1) {
+        while (w->count == 0 && w->busy > 0)
+            pthread_cond_wait(&w->more, &w->mutex);
+        if (w->count == 0) break;
+        char* path = w->stack[--w->count];
+        w->busy++;
+        pthread_mutex_unlock(&w->mutex);
+
+        if (buf) walk_dir(w, path, buf, &files);
+        else __atomic_fetch_add(&w->errors, 1, __ATOMIC_RELAXED);
+        free(path);
+        dirs++;
+
+        pthread_mutex_lock(&w->mutex);
+        if (--w->busy == 0 && w->count == 0) pthread_cond_broadcast(&w->more);
+    }
+    w->dirs += dirs;
+    w->files += files;
+    pthread_mutex_unlock(&w->mutex);
+    free(buf);
+    return NULL;
+}
+
+// roots 아래를 threads 개 스레드로 탐색, 끝날 때까지 기다림
+// 반환값: 읽지 못한 디렉터리 등 오류 수 (0 이면 성공)
+static inline int walk_parallel(char** roots, int n, int threads, walk_fn fn, void* ctx,
+                                long* dirs_out, long* files_out) {
+    Walk w;
+    memset(&w, 0, sizeof(w));
+    w.fn = fn;
+    w.ctx = ctx;
+    pthread_mutex_init(&w.mutex, NULL);
+    pthread_cond_init(&w.more, NULL);
+    for (int i = 0; i < n; i++) {
+        char* p = strdup(roots[i]);
+        if (!p || walk_push(&w, &p, 1) < 0) {
+            free(p);
+            w.errors++;
+        }
+    }
+    pthread_t tids[threads];
+    int started = 0;
+    while (started < threads && pthread_create(&tids[started], NULL, walk_thread, &w) == 0)
+        started++;
+    if (started == 0) walk_thread(&w);
+    for (int i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+
+    if (dirs_out) *dirs_out = w.dirs;
+    if (files_out) *files_out = w.files;
+    free(w.stack);
+    pthread_mutex_destroy(&w.mutex);
+    pthread_cond_destroy(&w.more);
+    return w.errors;
+}
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// 가상 작업(파일 크기) 생성기: 모든 전략이 같은 작업 목록으로 돌도록 공유
+//
+//   --workload table                          기본 60개 표 (1~100)
+//   --workload uniform:n=1000000,min=1,max=100
+//   --workload zipf:n=1000000,s=1.1,max=100   작은 작업이 대부분
+//   --workload lognormal:n=100000,mu=3,sigma=1,max=10000
+//   --workload bimodal:n=100000,tiny=1,huge=1000,frac=0.01
+//   --workload dir:/path/to/tree              디렉터리의 실제 파일 크기 분포 재생 (1 = 1KB)
+//
+// 공통 키: seed=N (기본 1), mult=N (run_cpu_for 배수), unit=N (크기 1 당 작업 버퍼 바이트)
+
+#define WORKLOAD_DEFAULT_N 60
+#define WORKLOAD_DIR_UNIT 1024  // dir: 파일 크기 1 단위 = 1KB
+
+// 기존 파일 크기 배열 (1~100 범위의 임의 수)
+static const int workload_table[WORKLOAD_DEFAULT_N] = {
+    73, 18, 94, 26, 51, 62, 37, 89, 5, 43,
+    77, 14, 35, 68, 92, 10, 23, 81, 6, 57,
+    49, 87, 30, 1, 99, 64, 12, 46, 91, 28,
+    39, 83, 7, 58, 100, 22, 75, 33, 9, 67,
+    29, 56, 44, 15, 79, 2, 88, 11, 93, 16,
+    84, 31, 21, 60, 70, 4, 95, 36, 47, 8
+};
+
+typedef struct {
+    char kind[16];
+    int count;
+    int* sizes;
+    unsigned long long seed;
+    int time_multiplier;    // 0 이면 프로그램 기본값
+    size_t bytes_per_unit;  // 0 이면 BYTES_PER_UNIT
+} Workload;
+
+// splitmix64: 시드가 같으면 어느 전략에서든 같은 목록
+static inline unsigned long long workload_next(unsigned long long* s) {
+    unsigned long long z = (*s += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// [0, 1) 균등 실수
+static inline double workload_uniform(unsigned long long* s) {
+    return (workload_next(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// "key=value" 목록에서 값을 찾음 (없으면 def)
+static inline double workload_param(const char* params, const char* key, double def) {
+    size_t klen = strlen(key);
+    for (const char* p = params; p && *p; ) {
+        if (strncmp(p, key, klen) == 0 && p[klen] == '=') return atof(p + klen + 1);
+        p = strchr(p, ',');
+        if (p) p++;
+    }
+    return def;
+}
+
+// dir: 재생용 크기 목록 (realloc 으로 늘림)
+typedef struct {
+    int* sizes;
+    int count, cap;
+} WorkloadDir;
+
+// 디렉터리 아래 일반 파일의 크기를 재귀적으로 수집 (심볼릭 링크는 따라가지 않음)
+static inline int workload_scan_dir(int dfd, WorkloadDir* d) {
+    DIR* dir = fdopendir(dfd);
+    if (!dir) {
+        close(dfd);
+        return -1;
+    }
+    struct dirent* e;
+    while ((e = readdir(dir)) != NULL) {
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+        struct stat st;
+        if (fstatat(dirfd(dir), e->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            int sub = openat(dirfd(dir), e->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+            if (sub >= 0) workload_scan_dir(sub, d);
+            continue;
+        }
+        if (!S_ISREG(st.st_mode)) continue;
+        if (d->count == d->cap) {
+            int cap = d->cap ? d->cap * 2 : 1024;
+            int* grown = realloc(d->sizes, sizeof(int) * cap);
+            if (!grown) break;
+            d->sizes = grown;
+            d->cap = cap;
+        }
+        long long units = (st.st_size + WORKLOAD_DIR_UNIT - 1) / WORKLOAD_DIR_UNIT;
+        d->sizes[d->count++] = units < 1 ? 1 : units > 1000000000 ? 1000000000 : (int)units;
+    }
+    closedir(dir);
+    return 0;
+}
+
+// spec 에 맞는 작업 목록 생성, 잘못된 spec 이면 -1
+static inline int workload_generate(Workload* w, const char* spec) {
+    memset(w, 0, sizeof(*w));
+    const char* colon = strchr(spec, ':');
+    size_t klen = colon ? (size_t)(colon - spec) : strlen(spec);
+    const char* params = colon ? colon + 1 : "";
+    if (klen == 0 || klen >= sizeof(w->kind)) {
+        fprintf(stderr, "Invalid workload '%s'.\n", spec);
+        return -1;
+    }
+    memcpy(w->kind, spec, klen);
+    w->kind[klen] = '\0';
+
+    if (strcmp(w->kind, "dir") == 0) {
+        WorkloadDir d = { NULL, 0, 0 };
+        int dfd = open(params, O_RDONLY | O_DIRECTORY);
+        if (dfd < 0 || workload_scan_dir(dfd, &d) < 0 || d.count == 0) {
+            fprintf(stderr, "No regular files found under '%s'.\n", params);
+            free(d.sizes);
+            return -1;
+        }
+        w->count = d.count;
+        w->sizes = d.sizes;
+        return 0;
+    }
+
+    int table = strcmp(w->kind, "table") == 0;
+    long n = (long)workload_param(params, "n", WORKLOAD_DEFAULT_N);
+    w->seed = (unsigned long long)workload_param(params, "seed", 1);
+    w->time_multiplier = (int)workload_param(params, "mult", 0);
+    w->bytes_per_unit = (size_t)workload_param(params, "unit", 0);
+    if (table) n = WORKLOAD_DEFAULT_N;
+    if (n < 1 || n > 100000000) {
+        fprintf(stderr, "Invalid workload size n=%ld (1 ~ 100000000).\n", n);
+        return -1;
+    }
+    w->count = (int)n;
+    w->sizes = malloc(sizeof(int) * n);
+    if (!w->sizes) {
+        fprintf(stderr, "Failed to allocate %ld workload entries.\n", n);
+        return -1;
+    }
+    unsigned long long s = w->seed;
+
+    if (table) {
+        memcpy(w->sizes, workload_table, sizeof(workload_table));
+    } else if (strcmp(w->kind, "uniform") == 0) {
+        int lo = (int)workload_param(params, "min", 1), hi = (int)workload_param(params, "max", 100);
+        if (lo < 1 || hi < lo) goto bad;
+        for (long i = 0; i < n; i++) w->sizes[i] = lo + (int)(workload_uniform(&s) * (hi - lo + 1));
+    } else if (strcmp(w->kind, "zipf") == 0) {
+        // 크기 k (1..max) 가 1/k^s 에 비례: 누적 분포표에서 이진 탐색
+        double z = workload_param(params, "s", 1.1);
+        int max = (int)workload_param(params, "max", 100);
+        if (max < 1 || z <= 0) goto bad;
+        double* cdf = malloc(sizeof(double) * max);
+        if (!cdf) goto bad;
+        double sum = 0;
+        for (int k = 1; k <= max; k++) cdf[k - 1] = (sum += pow(k, -z));
+        for (long i = 0; i < n; i++) {
+            double u = workload_uniform(&s) * sum;
+            int lo = 0, hi = max - 1;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (cdf[mid] < u) lo = mid + 1;
+                else hi = mid;
+            }
+            w->sizes[i] = lo + 1;
+        }
+        free(cdf);
+    } else if (strcmp(w->kind, "lognormal") == 0) {
+        double mu = workload_param(params, "mu", 3.0), sigma = workload_param(params, "sigma", 1.0);
+        int max = (int)workload_param(params, "max", 10000);
+        if (sigma < 0 || max < 1) goto bad;
+        for (long i = 0; i < n; i++) {
+            // Box-Muller
+            double u1 = 1.0 - workload_uniform(&s), u2 = workload_uniform(&s);
+            double g = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+            double v = exp(mu + sigma * g);
+            w->sizes[i] = v < 1 ? 1 : v > max ? max : (int)v;
+        }
+    } else if (strcmp(w->kind, "bimodal") == 0) {
+        // 작은 작업 다수 + 아주 큰 작업 소수
+        int tiny = (int)workload_param(params, "tiny", 1), huge = (int)workload_param(params, "huge", 1000);
+        double frac = workload_param(params, "frac", 0.01);
+        if (tiny < 1 || huge < 1 || frac < 0 || frac > 1) goto bad;
+        for (long i = 0; i < n; i++) w->sizes[i] = workload_uniform(&s) < frac ? huge : tiny;
+    } else {
+        fprintf(stderr, "Unknown workload '%s' (table, uniform, zipf, lognormal, bimodal, dir).\n", w->kind);
+        free(w->sizes);
+        w->sizes = NULL;
+        return -1;
+    }
+    return 0;
+
+bad:
+    fprintf(stderr, "Invalid parameters for workload '%s'.\n", spec);
+    free(w->sizes);
+    w->sizes = NULL;
+    return -1;
+}
+
+// 기본 작업 목록 (--workload 가 없을 때)
+static inline void workload_default(Workload* w) {
+    workload_generate(w, "table");
+}
+
+// argv 앞쪽의 "--workload spec" 을 읽고 제거 (없으면 기본 표), 실패하면 -1
+static inline int workload_args(int* argc, char*** argv, Workload* w) {
+    if (*argc >= 3 && strcmp((*argv)[1], "--workload") == 0) {
+        if (workload_generate(w, (*argv)[2]) < 0) return -1;
+        (*argv)[2] = (*argv)[0];
+        *argv += 2;
+        *argc -= 2;
+        return 0;
+    }
+    workload_default(w);
+    return 0;
+}
+
+// 작업 목록 요약 한 줄 (기본 표일 때는 출력하지 않음)
+static inline void workload_describe(const Workload* w, FILE* out) {
+    if (strcmp(w->kind, "table") == 0) return;
+    long long total = 0;
+    int lo = w->sizes[0], hi = w->sizes[0];
+    for (int i = 0; i < w->count; i++) {
+        total += w->sizes[i];
+        if (w->sizes[i] < lo) lo = w->sizes[i];
+        if (w->sizes[i] > hi) hi = w->sizes[i];
+    }
+    fprintf(out, "[workload] %s: %d tasks, size %d ~ %d (mean %.2f, total %lld)\n",
+        w->kind, w->count, lo, hi, (double)total / w->count, total);
+    fflush(out);
+}
+
+#endif